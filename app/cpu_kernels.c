@@ -0,0 +1,143 @@
+/**
+ * @file cpu_kernels.c
+ * @brief Int8 CPU reference kernels (generic and model-specialized)
+ */
+
+#include "cpu_kernels.h"
+#include "mem_stats.h"
+#include <string.h>
+#include "model_layers.h"
+
+/* Ping-pong activation buffers and zero-point padded input scratch */
+static int8_t cpu_act[2][CPU_ACT_SIZE] __attribute__((aligned(16)));
+static int8_t cpu_pad_buf[CPU_PAD_SIZE] __attribute__((aligned(16)));
+
+/* Section bounds from linker.ld */
+extern const uint8_t __cpu_generic_start[], __cpu_generic_end[];
+extern const uint8_t __cpu_spec_start[], __cpu_spec_end[];
+
+#include "model_kernels.h"
+
+CPU_GENERIC_KERNEL
+void cpu_conv2d_s8(const cpu_layer_t* l, const int8_t* in, int8_t* out) {
+    for (int oy = 0; oy < l->out_h; oy++) {
+        for (int ox = 0; ox < l->out_w; ox++) {
+            int iy0 = oy * l->stride_h - l->pad_top;
+            int ix0 = ox * l->stride_w - l->pad_left;
+            for (int oc = 0; oc < l->out_c; oc++) {
+                const int8_t* w = l->weights +
+                                  (size_t)oc * l->filter_h * l->filter_w * l->in_c;
+                int32_t acc = l->bias ? l->bias[oc] : 0;
+                for (int ky = 0; ky < l->filter_h; ky++) {
+                    int iy = iy0 + ky;
+                    if (iy < 0 || iy >= l->in_h) continue;
+                    for (int kx = 0; kx < l->filter_w; kx++) {
+                        int ix = ix0 + kx;
+                        if (ix < 0 || ix >= l->in_w) continue;
+                        const int8_t* px = in + ((size_t)iy * l->in_w + ix) * l->in_c;
+                        const int8_t* wk = w + ((size_t)ky * l->filter_w + kx) * l->in_c;
+                        for (int ic = 0; ic < l->in_c; ic++) {
+                            acc += (px[ic] - l->in_zp) * wk[ic];
+                        }
+                    }
+                }
+                out[((size_t)oy * l->out_w + ox) * l->out_c + oc] =
+                    cpu_requant_s8(acc, l->multiplier[oc], l->shift[oc],
+                                   l->out_zp, l->act_min, l->act_max);
+            }
+        }
+    }
+}
+
+CPU_GENERIC_KERNEL
+void cpu_maxpool2d_s8(const cpu_layer_t* l, const int8_t* in, int8_t* out) {
+    for (int oy = 0; oy < l->out_h; oy++) {
+        for (int ox = 0; ox < l->out_w; ox++) {
+            int iy0 = oy * l->stride_h - l->pad_top;
+            int ix0 = ox * l->stride_w - l->pad_left;
+            for (int c = 0; c < l->out_c; c++) {
+                int32_t m = -128;
+                for (int ky = 0; ky < l->filter_h; ky++) {
+                    int iy = iy0 + ky;
+                    if (iy < 0 || iy >= l->in_h) continue;
+                    for (int kx = 0; kx < l->filter_w; kx++) {
+                        int ix = ix0 + kx;
+                        if (ix < 0 || ix >= l->in_w) continue;
+                        int32_t v = in[((size_t)iy * l->in_w + ix) * l->in_c + c];
+                        if (v > m) m = v;
+                    }
+                }
+                if (m < l->act_min) m = l->act_min;
+                if (m > l->act_max) m = l->act_max;
+                out[((size_t)oy * l->out_w + ox) * l->out_c + c] = (int8_t)m;
+            }
+        }
+    }
+}
+
+CPU_GENERIC_KERNEL
+void cpu_fully_connected_s8(const cpu_layer_t* l, const int8_t* in, int8_t* out) {
+    size_t depth = (size_t)l->in_h * l->in_w * l->in_c;
+    for (int oc = 0; oc < l->out_c; oc++) {
+        const int8_t* w = l->weights + (size_t)oc * depth;
+        int32_t acc = l->bias ? l->bias[oc] : 0;
+        for (size_t i = 0; i < depth; i++) {
+            acc += (in[i] - l->in_zp) * w[i];
+        }
+        out[oc] = cpu_requant_s8(acc, l->multiplier[oc], l->shift[oc],
+                                 l->out_zp, l->act_min, l->act_max);
+    }
+}
+
+CPU_GENERIC_KERNEL
+static void cpu_generic_run(const int8_t* input, int8_t* output) {
+    const int8_t* src = input;
+    for (int i = 0; i < CPU_NUM_LAYERS; i++) {
+        const cpu_layer_t* l = &cpu_layers[i];
+        int8_t* dst = (i == CPU_NUM_LAYERS - 1) ? output : cpu_act[i & 1];
+        switch (l->op) {
+            case CPU_OP_CONV2D:          cpu_conv2d_s8(l, src, dst); break;
+            case CPU_OP_MAXPOOL2D:       cpu_maxpool2d_s8(l, src, dst); break;
+            case CPU_OP_FULLY_CONNECTED: cpu_fully_connected_s8(l, src, dst); break;
+            default: break;
+        }
+        src = dst;
+    }
+}
+
+int cpu_kernels_available(void) { return CPU_LAYERS_SUPPORTED; }
+
+int cpu_run_inference(int variant, const int8_t* input, size_t input_size,
+                      int8_t* output, size_t output_size) {
+    if (!CPU_LAYERS_SUPPORTED) return CPU_ERROR_MODEL;
+    if (input_size != CPU_INPUT_SIZE || output_size < CPU_OUTPUT_SIZE)
+        return CPU_ERROR_SIZE;
+
+    if (variant == CPU_KERNELS_SPECIALIZED) {
+        cpu_spec_run(input, output);
+    } else {
+        cpu_generic_run(input, output);
+    }
+    return CPU_OK;
+}
+
+uint32_t cpu_kernels_code_size(int variant) {
+    if (variant == CPU_KERNELS_SPECIALIZED)
+        return (uint32_t)(__cpu_spec_end - __cpu_spec_start);
+    return (uint32_t)(__cpu_generic_end - __cpu_generic_start);
+}
+
+void cpu_scratch_reset_watermark(void) {
+    mem_paint(cpu_act, sizeof(cpu_act));
+    mem_paint(cpu_pad_buf, sizeof(cpu_pad_buf));
+}
+
+uint32_t cpu_scratch_high_water(void) {
+    return (uint32_t)(mem_watermark_up(cpu_act[0], CPU_ACT_SIZE) +
+                      mem_watermark_up(cpu_act[1], CPU_ACT_SIZE) +
+                      mem_watermark_up(cpu_pad_buf, CPU_PAD_SIZE));
+}
+
+uint32_t cpu_scratch_size(void) {
+    return (uint32_t)(sizeof(cpu_act) + sizeof(cpu_pad_buf));
+}
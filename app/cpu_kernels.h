@@ -0,0 +1,73 @@
+/**
+ * @file cpu_kernels.h
+ * @brief Int8 CPU reference kernels for Cortex-M55
+ *
+ * Generic kernels take their bounds from a cpu_layer_t descriptor at
+ * runtime. generate_headers.py emits the descriptors for the deployed
+ * model (model_layers.h) plus kernels specialized for each layer's exact
+ * dimensions (model_kernels.h).
+ */
+
+#ifndef CPU_KERNELS_H
+#define CPU_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CPU_OK              0
+#define CPU_ERROR_MODEL     -1
+#define CPU_ERROR_SIZE      -2
+
+/* Kernel variants */
+#define CPU_KERNELS_GENERIC      0
+#define CPU_KERNELS_SPECIALIZED  1
+
+/* Layer operators */
+#define CPU_OP_CONV2D           0
+#define CPU_OP_MAXPOOL2D        1
+#define CPU_OP_FULLY_CONNECTED  2
+
+/* Keep each variant contiguous so its code size can be measured */
+#define CPU_GENERIC_KERNEL  __attribute__((section(".text.cpu_generic"), noinline))
+#define CPU_SPEC_KERNEL     __attribute__((section(".text.cpu_spec"), noinline))
+
+typedef struct {
+    uint8_t op;
+    uint16_t in_h, in_w, in_c;
+    uint16_t out_h, out_w, out_c;
+    uint8_t filter_h, filter_w;
+    uint8_t stride_h, stride_w;
+    uint8_t pad_top, pad_left;
+    int32_t in_zp, out_zp;
+    int32_t act_min, act_max;
+    const int8_t* weights;      /* [out_c][filter_h][filter_w][in_c] */
+    const int32_t* bias;        /* [out_c] */
+    const int32_t* multiplier;  /* [out_c] Q31 requantization multiplier */
+    const int32_t* shift;       /* [out_c] left shift (negative = right) */
+} cpu_layer_t;
+
+/* Scale an int32 accumulator back to int8 (single-rounding Q31 multiply) */
+static inline int8_t cpu_requant_s8(int32_t acc, int32_t mult, int32_t shift,
+                                    int32_t out_zp, int32_t act_min,
+                                    int32_t act_max) {
+    int32_t total_shift = 31 - shift;
+    int64_t prod = (int64_t)acc * mult + ((int64_t)1 << (total_shift - 1));
+    int32_t v = (int32_t)(prod >> total_shift) + out_zp;
+    if (v < act_min) v = act_min;
+    if (v > act_max) v = act_max;
+    return (int8_t)v;
+}
+
+void cpu_conv2d_s8(const cpu_layer_t* l, const int8_t* in, int8_t* out);
+void cpu_maxpool2d_s8(const cpu_layer_t* l, const int8_t* in, int8_t* out);
+void cpu_fully_connected_s8(const cpu_layer_t* l, const int8_t* in, int8_t* out);
+
+int cpu_kernels_available(void);
+int cpu_run_inference(int variant, const int8_t* input, size_t input_size,
+                      int8_t* output, size_t output_size);
+uint32_t cpu_kernels_code_size(int variant);
+void cpu_scratch_reset_watermark(void);
+uint32_t cpu_scratch_high_water(void);
+uint32_t cpu_scratch_size(void);
+
+#endif /* CPU_KERNELS_H */
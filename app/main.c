@@ -8,6 +8,8 @@
 #include <string.h>
 #include "SEGGER_RTT.h"
 #include "npu_driver.h"
+#include "cpu_kernels.h"
+#include "mem_stats.h"
 #include "mnist_model_data.h"
 #include "test_data.h"
 #include "model_config.h"
@@ -22,6 +24,28 @@ typedef struct {
 static SysTick_TypeDef* const SysTick = (SysTick_TypeDef*)SYSTICK_BASE;
 static int8_t output_scores[MODEL_OUTPUT_SIZE];
 
+static const char* layout_name[2] = { "NHWC", "NHCWB16" };
+
+/* Peak memory use per inference path */
+#define MEM_PATH_NPU            0
+#define MEM_PATH_CPU_GENERIC    1
+#define MEM_PATH_CPU_SPEC       2
+#define MEM_NUM_PATHS           3
+
+typedef struct {
+    const char* name;
+    uint32_t runs;
+    uint32_t arena_peak;
+    uint32_t scratch_peak;
+    uint32_t stack_peak;
+} mem_path_t;
+
+static mem_path_t mem_paths[MEM_NUM_PATHS] = {
+    { "NPU", 0, 0, 0, 0 },
+    { "CPU generic", 0, 0, 0, 0 },
+    { "CPU specialized", 0, 0, 0, 0 },
+};
+
 /* ASCII art digits */
 static const char* digit_art[10][5] = {
     {" ### ", "#   #", "#   #", "#   #", " ### "},  /* 0 */
@@ -51,6 +75,36 @@ static uint32_t cycles_to_us(uint32_t c) {
     return c / CYCLES_PER_US; 
 }
 
+static uint32_t systick_elapsed(uint32_t start, uint32_t end) {
+    return (start >= end) ? (start - end) : ((0xFFFFFF - end) + start);
+}
+
+static void mem_path_begin(void) {
+    npu_arena_reset_watermark();
+    cpu_scratch_reset_watermark();
+    mem_stack_reset();
+}
+
+static void mem_path_end(int path) {
+    mem_path_t* p = &mem_paths[path];
+    uint32_t arena = npu_arena_high_water();
+    uint32_t scratch = cpu_scratch_high_water();
+    uint32_t stack = mem_stack_used();
+    p->runs++;
+    if (arena > p->arena_peak) p->arena_peak = arena;
+    if (scratch > p->scratch_peak) p->scratch_peak = scratch;
+    if (stack > p->stack_peak) p->stack_peak = stack;
+}
+
+/* Input slot layout for NHWC test data */
+static int select_slot_layout(uint8_t slot_layout) {
+    npu_input_config_t cfg = {
+        slot_layout, NPU_LAYOUT_NHWC,
+        MODEL_INPUT_HEIGHT, MODEL_INPUT_WIDTH, MODEL_INPUT_CHANNELS
+    };
+    return npu_configure_input(&cfg);
+}
+
 static void print_banner(void) {
     SEGGER_RTT_WriteString(0, "\r\n");
     SEGGER_RTT_WriteString(0, "========================================\r\n");
@@ -105,14 +159,15 @@ static void run_demo_inference(void) {
     SEGGER_RTT_WriteString(0, "Running inference on test image...\r\n");
     SEGGER_RTT_printf(0, "Expected digit: %d\r\n", EXPECTED_DIGIT);
     
+    mem_path_begin();
     uint32_t start = systick_get();
     int result = npu_run_inference(mnist_model_data, MNIST_MODEL_SIZE,
                                    test_input_data, TEST_IMAGE_SIZE,
                                    output_scores, MODEL_OUTPUT_SIZE);
     uint32_t end = systick_get();
+    mem_path_end(MEM_PATH_NPU);
     
-    uint32_t elapsed = (start >= end) ? (start - end) : ((0xFFFFFF - end) + start);
-    uint32_t us = cycles_to_us(elapsed);
+    uint32_t us = cycles_to_us(systick_elapsed(start, end));
     
     if (result != NPU_OK) {
         SEGGER_RTT_printf(0, "ERROR: Inference failed (%d)\r\n", result);
@@ -135,20 +190,26 @@ static void run_demo_inference(void) {
 static void run_benchmark(int iterations) {
     SEGGER_RTT_printf(0, "Running benchmark: %d iterations...\r\n", iterations);
     
+    uint32_t npu_cycles = 0, rd_beats = 0, wr_beats = 0;
+    npu_perf_t perf;
+    mem_path_begin();
     uint32_t total_start = systick_get();
     for (int i = 0; i < iterations; i++) {
         npu_run_inference(mnist_model_data, MNIST_MODEL_SIZE,
                          test_input_data, TEST_IMAGE_SIZE,
                          output_scores, MODEL_OUTPUT_SIZE);
+        npu_get_perf(&perf);
+        npu_cycles += perf.cycles;
+        rd_beats += perf.axi_read_beats;
+        wr_beats += perf.axi_write_beats;
         if ((i + 1) % 100 == 0) {
             SEGGER_RTT_printf(0, "  Completed: %d\r\n", i + 1);
         }
     }
     uint32_t total_end = systick_get();
+    mem_path_end(MEM_PATH_NPU);
     
-    uint32_t elapsed = (total_start >= total_end) ? 
-                       (total_start - total_end) : ((0xFFFFFF - total_end) + total_start);
-    uint32_t us = cycles_to_us(elapsed);
+    uint32_t us = cycles_to_us(systick_elapsed(total_start, total_end));
     
     SEGGER_RTT_WriteString(0, "\r\n");
     SEGGER_RTT_WriteString(0, "========================================\r\n");
@@ -158,6 +219,140 @@ static void run_benchmark(int iterations) {
     SEGGER_RTT_printf(0, "  Total time: %u us\r\n", us);
     SEGGER_RTT_printf(0, "  Avg/inference: %u us\r\n", us / iterations);
     SEGGER_RTT_printf(0, "  Throughput: %u FPS\r\n", (iterations * 1000000UL) / us);
+    SEGGER_RTT_printf(0, "  NPU cycles/inference: %u\r\n", npu_cycles / iterations);
+    SEGGER_RTT_printf(0, "  AXI read/inference: %u beats (%u bytes)\r\n",
+                      rd_beats / iterations,
+                      (rd_beats / iterations) * NPU_AXI_BEAT_BYTES);
+    SEGGER_RTT_printf(0, "  AXI write/inference: %u beats (%u bytes)\r\n",
+                      wr_beats / iterations,
+                      (wr_beats / iterations) * NPU_AXI_BEAT_BYTES);
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_WriteString(0, "\r\n");
+}
+
+/* CPU cost of filling the arena input slot. The NPU always reads NHWC, so
+ * the brick slots are only staged, never run. */
+static void run_packing_benchmark(int iterations) {
+    static const uint8_t slot_layouts[2] = {
+        NPU_LAYOUT_NHWC,     /* plain copy */
+        NPU_LAYOUT_NHCWB16,  /* driver packs bricks */
+    };
+
+    SEGGER_RTT_printf(0, "Comparing input slot packing: %d iterations each...\r\n",
+                      iterations);
+    SEGGER_RTT_WriteString(0, "\r\n");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_WriteString(0, "INPUT PACKING COMPARISON\r\n");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+
+    for (int c = 0; c < 2; c++) {
+        if (select_slot_layout(slot_layouts[c]) != NPU_OK) {
+            SEGGER_RTT_WriteString(0, "  ERROR: layout not supported\r\n");
+            continue;
+        }
+
+        size_t slot_bytes = 0;
+        uint32_t start = systick_get();
+        for (int i = 0; i < iterations; i++) {
+            slot_bytes = npu_stage_input(MNIST_MODEL_SIZE, test_input_data,
+                                         TEST_IMAGE_SIZE);
+        }
+        uint32_t cycles = systick_elapsed(start, systick_get());
+
+        SEGGER_RTT_printf(0, "  %s slot <- NHWC input (%u bytes)\r\n",
+                          layout_name[slot_layouts[c]], (unsigned)TEST_IMAGE_SIZE);
+        if (slot_bytes == 0) {
+            SEGGER_RTT_WriteString(0, "    ERROR: slot does not fit the arena\r\n");
+            continue;
+        }
+        SEGGER_RTT_printf(0, "    Cycles/fill: %u\r\n", cycles / iterations);
+        SEGGER_RTT_printf(0, "    Slot bytes:  %u\r\n", (unsigned)slot_bytes);
+    }
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_WriteString(0, "\r\n");
+
+    select_slot_layout(NPU_LAYOUT_NHWC);
+}
+
+static uint32_t time_cpu_inference(int variant, int iterations, int8_t* out) {
+    uint32_t cycles = 0;
+    mem_path_begin();
+    for (int i = 0; i < iterations; i++) {
+        uint32_t start = systick_get();
+        cpu_run_inference(variant, test_input_data, TEST_IMAGE_SIZE,
+                          out, MODEL_OUTPUT_SIZE);
+        cycles += systick_elapsed(start, systick_get());
+    }
+    mem_path_end(variant == CPU_KERNELS_SPECIALIZED ? MEM_PATH_CPU_SPEC
+                                                    : MEM_PATH_CPU_GENERIC);
+    return cycles / iterations;
+}
+
+static void run_cpu_kernel_benchmark(int iterations) {
+    int8_t generic_out[MODEL_OUTPUT_SIZE];
+    int8_t spec_out[MODEL_OUTPUT_SIZE];
+
+    if (!cpu_kernels_available()) {
+        SEGGER_RTT_WriteString(0, "CPU kernels not generated for this model.\r\n");
+        return;
+    }
+
+    SEGGER_RTT_printf(0, "Comparing CPU kernels: %d iterations each...\r\n",
+                      iterations);
+    uint32_t generic_cycles = time_cpu_inference(CPU_KERNELS_GENERIC,
+                                                 iterations, generic_out);
+    uint32_t spec_cycles = time_cpu_inference(CPU_KERNELS_SPECIALIZED,
+                                              iterations, spec_out);
+    uint32_t generic_size = cpu_kernels_code_size(CPU_KERNELS_GENERIC);
+    uint32_t spec_size = cpu_kernels_code_size(CPU_KERNELS_SPECIALIZED);
+    int match = memcmp(generic_out, spec_out, MODEL_OUTPUT_SIZE) == 0;
+
+    SEGGER_RTT_WriteString(0, "\r\n");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_WriteString(0, "CPU KERNEL COMPARISON\r\n");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_printf(0, "  Generic:     %u cycles (%u us), %u bytes code\r\n",
+                      generic_cycles, cycles_to_us(generic_cycles), generic_size);
+    SEGGER_RTT_printf(0, "  Specialized: %u cycles (%u us), %u bytes code\r\n",
+                      spec_cycles, cycles_to_us(spec_cycles), spec_size);
+    if (spec_cycles > 0) {
+        uint32_t x100 = (uint32_t)(((uint64_t)generic_cycles * 100) / spec_cycles);
+        SEGGER_RTT_printf(0, "  Speedup: %u.%u%ux\r\n",
+                          x100 / 100, (x100 / 10) % 10, x100 % 10);
+    }
+    SEGGER_RTT_printf(0, "  Code-size cost: %d bytes\r\n",
+                      (int)spec_size - (int)generic_size);
+    SEGGER_RTT_printf(0, "  Predicted digit: %d (outputs %s)\r\n",
+                      argmax_int8(spec_out, MODEL_OUTPUT_SIZE),
+                      match ? "match" : "DIFFER");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_WriteString(0, "\r\n");
+}
+
+static void show_memory_usage(void) {
+    SEGGER_RTT_WriteString(0, "\r\n");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_WriteString(0, "MEMORY USAGE (high-water)\r\n");
+    SEGGER_RTT_WriteString(0, "========================================\r\n");
+    SEGGER_RTT_printf(0, "  Stack: %u / %u bytes since boot\r\n",
+                      mem_stack_peak(), mem_stack_size());
+    SEGGER_RTT_printf(0, "  Heap:  %u / %u bytes\r\n",
+                      mem_heap_used(), mem_heap_size());
+    SEGGER_RTT_printf(0, "  NPU arena:   %u bytes (.tensor_arena)\r\n",
+                      (unsigned)NPU_ARENA_SIZE);
+    SEGGER_RTT_printf(0, "  CPU scratch: %u bytes\r\n", cpu_scratch_size());
+    SEGGER_RTT_WriteString(0, "----------------------------------------\r\n");
+    for (int i = 0; i < MEM_NUM_PATHS; i++) {
+        const mem_path_t* p = &mem_paths[i];
+        if (p->runs == 0) {
+            SEGGER_RTT_printf(0, "  %s: not run yet\r\n", p->name);
+            continue;
+        }
+        SEGGER_RTT_printf(0, "  %s (%u runs)\r\n", p->name, p->runs);
+        SEGGER_RTT_printf(0, "    Arena:   %u bytes\r\n", p->arena_peak);
+        SEGGER_RTT_printf(0, "    Scratch: %u bytes\r\n", p->scratch_peak);
+        SEGGER_RTT_printf(0, "    Stack:   %u bytes\r\n", p->stack_peak);
+    }
     SEGGER_RTT_WriteString(0, "========================================\r\n");
     SEGGER_RTT_WriteString(0, "\r\n");
 }
@@ -169,6 +364,10 @@ static void print_menu(void) {
     SEGGER_RTT_WriteString(0, "  3 - Run benchmark (1000 iterations)\r\n");
     SEGGER_RTT_WriteString(0, "  4 - Show model info\r\n");
     SEGGER_RTT_WriteString(0, "  5 - Show output scores\r\n");
+    SEGGER_RTT_WriteString(0, "  6 - Compare input slot packing (NHWC copy vs NHCWB16)\r\n");
+    SEGGER_RTT_WriteString(0, "  7 - Compare CPU kernels (generic vs specialized)\r\n");
+    SEGGER_RTT_WriteString(0, "  8 - Show memory usage\r\n");
+    SEGGER_RTT_WriteString(0, "  b - Run full benchmark suite\r\n");
     SEGGER_RTT_WriteString(0, "  h - Show this menu\r\n");
     SEGGER_RTT_WriteString(0, "\r\n> ");
 }
@@ -180,6 +379,7 @@ static void show_model_info(void) {
     SEGGER_RTT_WriteString(0, "========================================\r\n");
     SEGGER_RTT_printf(0, "  Model size: %u bytes\r\n", MNIST_MODEL_SIZE);
     SEGGER_RTT_printf(0, "  Input size: %d (28x28x1)\r\n", MODEL_INPUT_SIZE);
+    SEGGER_RTT_printf(0, "  Input layout: NHWC (%u bytes)\r\n", (unsigned)TEST_IMAGE_SIZE);
     SEGGER_RTT_printf(0, "  Output: %d classes\r\n", MODEL_OUTPUT_SIZE);
     SEGGER_RTT_printf(0, "  Arena: %u bytes\r\n", TENSOR_ARENA_SIZE);
     SEGGER_RTT_WriteString(0, "========================================\r\n");
@@ -199,6 +399,18 @@ static void show_scores(void) {
     SEGGER_RTT_WriteString(0, "\r\n");
 }
 
+/* Everything scripts/perf_gate.py parses, in one capture */
+static void run_benchmark_suite(void) {
+    SEGGER_RTT_WriteString(0, "=== BENCHMARK SUITE BEGIN ===\r\n");
+    show_model_info();
+    run_demo_inference();
+    run_benchmark(100);
+    run_packing_benchmark(100);
+    run_cpu_kernel_benchmark(10);
+    show_memory_usage();
+    SEGGER_RTT_WriteString(0, "=== BENCHMARK SUITE END ===\r\n");
+}
+
 static void delay_ms(uint32_t ms) {
     for (volatile uint32_t i = 0; i < ms * 16000; i++) {
         __asm__("nop");
@@ -206,6 +418,7 @@ static void delay_ms(uint32_t ms) {
 }
 
 int main(void) {
+    mem_stats_init();
     systick_init();
     SEGGER_RTT_Init();
     
@@ -217,6 +430,7 @@ int main(void) {
     SEGGER_RTT_WriteString(0, "Initializing NPU... ");
     int r = npu_init();
     SEGGER_RTT_WriteString(0, (r == NPU_OK) ? "OK\r\n" : "FAILED\r\n");
+    select_slot_layout(NPU_LAYOUT_NHWC);
     SEGGER_RTT_WriteString(0, "\r\n");
     
     /* Run initial inference */
@@ -237,6 +451,10 @@ int main(void) {
                 case '3': run_benchmark(1000); break;
                 case '4': show_model_info(); break;
                 case '5': show_scores(); break;
+                case '6': run_packing_benchmark(100); break;
+                case '7': run_cpu_kernel_benchmark(10); break;
+                case '8': show_memory_usage(); break;
+                case 'b': case 'B': run_benchmark_suite(); break;
                 case 'h': case 'H': case '?': print_menu(); break;
                 default: 
                     SEGGER_RTT_WriteString(0, "Unknown command. Press 'h' for help.\r\n"); 
@@ -0,0 +1,72 @@
+/**
+ * @file mem_stats.c
+ * @brief Stack/heap painting and buffer high-water tracking
+ */
+
+#include "mem_stats.h"
+
+/* Region bounds from linker.ld */
+extern uint32_t _sstack, _estack;
+extern uint32_t _sheap, _eheap;
+
+/* Leave room below the caller's frame so painting doesn't clobber it */
+#define STACK_PAINT_MARGIN  64
+
+/* Stack peak folded in before each repaint, so it covers the whole boot */
+static uint32_t stack_peak = 0;
+
+static void paint_words(uint32_t* start, uint32_t* end) {
+    for (volatile uint32_t* p = start; p < end; p++) *p = MEM_PAINT_PATTERN;
+}
+
+void mem_paint(void* start, size_t size) {
+    uint32_t* p = (uint32_t*)start;
+    paint_words(p, p + size / sizeof(uint32_t));
+}
+
+size_t mem_watermark_up(const void* start, size_t size) {
+    const uint32_t* p = (const uint32_t*)start;
+    size_t n = size / sizeof(uint32_t);
+    while (n > 0 && p[n - 1] == MEM_PAINT_PATTERN) n--;
+    return n * sizeof(uint32_t);
+}
+
+/* Paint the free part of the stack below the current frame */
+static void paint_stack(void) {
+    uint32_t marker;
+    uintptr_t sp = (uintptr_t)&marker - STACK_PAINT_MARGIN;
+    paint_words(&_sstack, (uint32_t*)(sp & ~(uintptr_t)3));
+}
+
+void mem_stack_reset(void) {
+    stack_peak = mem_stack_peak();
+    paint_stack();
+}
+
+void mem_stats_init(void) {
+    mem_paint(&_sheap, mem_heap_size());
+    paint_stack();
+}
+
+uint32_t mem_stack_used(void) {
+    const uint32_t* p = &_sstack;
+    while (p < &_estack && *p == MEM_PAINT_PATTERN) p++;
+    return (uint32_t)((uintptr_t)&_estack - (uintptr_t)p);
+}
+
+uint32_t mem_stack_peak(void) {
+    uint32_t used = mem_stack_used();
+    return (used > stack_peak) ? used : stack_peak;
+}
+
+uint32_t mem_stack_size(void) {
+    return (uint32_t)((uintptr_t)&_estack - (uintptr_t)&_sstack);
+}
+
+uint32_t mem_heap_used(void) {
+    return (uint32_t)mem_watermark_up(&_sheap, mem_heap_size());
+}
+
+uint32_t mem_heap_size(void) {
+    return (uint32_t)((uintptr_t)&_eheap - (uintptr_t)&_sheap);
+}
@@ -0,0 +1,26 @@
+/**
+ * @file mem_stats.h
+ * @brief Stack/heap painting and buffer high-water tracking
+ */
+
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MEM_PAINT_PATTERN   0xC5C5C5C5UL
+
+void mem_stats_init(void);
+void mem_stack_reset(void);
+uint32_t mem_stack_used(void);      /* since the last mem_stack_reset */
+uint32_t mem_stack_peak(void);      /* since boot */
+uint32_t mem_stack_size(void);
+uint32_t mem_heap_used(void);
+uint32_t mem_heap_size(void);
+
+/* Buffers filled from the low end (arenas, scratch) */
+void mem_paint(void* start, size_t size);
+size_t mem_watermark_up(const void* start, size_t size);
+
+#endif /* MEM_STATS_H */
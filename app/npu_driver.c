@@ -4,6 +4,7 @@
  */
 
 #include "npu_driver.h"
+#include "mem_stats.h"
 #include <string.h>
 
 typedef struct {
@@ -13,16 +14,28 @@ typedef struct {
     volatile uint32_t PMCR, PMCNTENSET, PMCNTENCLR;
     volatile uint32_t PMOVSSET, PMOVSCLR, PMINTSET, PMINTCLR;
     volatile uint32_t PMCCNTR_LO, PMCCNTR_HI, PMCCNTR_CFG;
+    volatile uint32_t PMEVCNTR[4], PMEVTYPER[4];
 } NPU_TypeDef;
 
 static NPU_TypeDef* const NPU = (NPU_TypeDef*)NPU_BASE_ADDR;
-static uint8_t tensor_arena[NPU_ARENA_SIZE] __attribute__((aligned(16)));
+static uint8_t tensor_arena[NPU_ARENA_SIZE]
+    __attribute__((aligned(16), section(".tensor_arena")));
 static uint32_t last_cycles = 0;
+static npu_perf_t last_perf;
+static npu_input_config_t input_cfg = {
+    NPU_LAYOUT_NHWC, NPU_LAYOUT_NHWC, 28, 28, 1
+};
 
 #define NPU_CMD_START   0x01
 #define NPU_CMD_STOP    0x00
 #define NPU_STATUS_BUSY (1U << 0)
 
+/* PMU event counter assignment */
+#define NPU_PMU_EVT_AXI0_RD_BEATS   0x82
+#define NPU_PMU_EVT_AXI0_WR_BEATS   0x87
+#define NPU_PMU_CNT_AXI_RD          0
+#define NPU_PMU_CNT_AXI_WR          1
+
 static void delay_cycles(uint32_t n) {
     for (volatile uint32_t i = 0; i < n; i++) __asm__("nop");
 }
@@ -38,21 +51,92 @@ int npu_init(void) {
     
     NPU->PMCR = 0x01;
     NPU->PMCCNTR_CFG = 0x01;
-    NPU->PMCNTENSET = 0x80000001;
+    NPU->PMEVTYPER[NPU_PMU_CNT_AXI_RD] = NPU_PMU_EVT_AXI0_RD_BEATS;
+    NPU->PMEVTYPER[NPU_PMU_CNT_AXI_WR] = NPU_PMU_EVT_AXI0_WR_BEATS;
+    NPU->PMCNTENSET = 0x80000000 | (1U << NPU_PMU_CNT_AXI_RD) |
+                      (1U << NPU_PMU_CNT_AXI_WR);
     
-    memset(tensor_arena, 0, NPU_ARENA_SIZE);
+    npu_arena_reset_watermark();
+    return NPU_OK;
+}
+
+void npu_arena_reset_watermark(void) {
+    mem_paint(tensor_arena, NPU_ARENA_SIZE);
+}
+
+uint32_t npu_arena_high_water(void) {
+    return (uint32_t)mem_watermark_up(tensor_arena, NPU_ARENA_SIZE);
+}
+
+static size_t layout_size(int layout, const npu_input_config_t* cfg) {
+    if (layout == NPU_LAYOUT_NHCWB16)
+        return NPU_NHCWB16_SIZE(cfg->height, cfg->width, cfg->channels);
+    return (size_t)cfg->height * cfg->width * cfg->channels;
+}
+
+int npu_configure_input(const npu_input_config_t* cfg) {
+    if (!cfg || cfg->height == 0 || cfg->width == 0 || cfg->channels == 0)
+        return NPU_ERROR_INIT;
+    if (cfg->slot_layout > NPU_LAYOUT_NHCWB16 ||
+        cfg->source_layout > NPU_LAYOUT_NHCWB16)
+        return NPU_ERROR_INIT;
+    /* Bricks can be built from NHWC, but not flattened back */
+    if (cfg->slot_layout == NPU_LAYOUT_NHWC &&
+        cfg->source_layout == NPU_LAYOUT_NHCWB16)
+        return NPU_ERROR_INIT;
+    input_cfg = *cfg;
     return NPU_OK;
 }
 
+void npu_nhwc_to_nhcwb16(const int8_t* src, int8_t* dst,
+                         size_t height, size_t width, size_t channels) {
+    size_t bricks = (channels + NPU_BRICK_DEPTH - 1) / NPU_BRICK_DEPTH;
+    memset(dst, 0, NPU_NHCWB16_SIZE(height, width, channels));
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            const int8_t* px = src + (y * width + x) * channels;
+            for (size_t c = 0; c < channels; c++) {
+                size_t b = c / NPU_BRICK_DEPTH;
+                dst[((y * bricks + b) * width + x) * NPU_BRICK_DEPTH +
+                    (c % NPU_BRICK_DEPTH)] = px[c];
+            }
+        }
+    }
+}
+
+/* Copy the input into its arena slot, packing to bricks if required */
+size_t npu_stage_input(size_t model_size, const int8_t* input,
+                       size_t input_size) {
+    const npu_input_config_t* cfg = &input_cfg;
+    size_t slot_size = layout_size(cfg->slot_layout, cfg);
+    if (!input || input_size != layout_size(cfg->source_layout, cfg)) return 0;
+    if (model_size > NPU_ARENA_SIZE / 2 ||
+        slot_size > NPU_ARENA_SIZE - model_size) return 0;
+
+    int8_t* slot = (int8_t*)(tensor_arena + model_size);
+    if (cfg->slot_layout == cfg->source_layout) {
+        memcpy(slot, input, input_size);
+    } else {
+        npu_nhwc_to_nhcwb16(input, slot, cfg->height, cfg->width,
+                            cfg->channels);
+    }
+    return slot_size;
+}
+
 int npu_run_inference(const uint8_t* model_data, size_t model_size,
                       const int8_t* input, size_t input_size,
                       int8_t* output, size_t output_size) {
     NPU->PMCCNTR_LO = 0;
     NPU->PMCCNTR_HI = 0;
+    NPU->PMEVCNTR[NPU_PMU_CNT_AXI_RD] = 0;
+    NPU->PMEVCNTR[NPU_PMU_CNT_AXI_WR] = 0;
     
+    /* Vela command streams read the graph input as NHWC */
+    if (input_cfg.slot_layout != NPU_LAYOUT_NHWC) return NPU_ERROR_INIT;
     if (model_size > NPU_ARENA_SIZE / 2) return NPU_ERROR_INIT;
     memcpy(tensor_arena, model_data, model_size);
-    memcpy(tensor_arena + model_size, input, input_size);
+    if (npu_stage_input(model_size, input, input_size) == 0) return NPU_ERROR_INIT;
+    const int8_t* slot = (const int8_t*)(tensor_arena + model_size);
     
     NPU->QBASE0 = (uint32_t)(uintptr_t)tensor_arena;
     NPU->QSIZE = NPU_ARENA_SIZE;
@@ -64,14 +148,17 @@ int npu_run_inference(const uint8_t* model_data, size_t model_size,
     if (timeout == 0) { NPU->CMD = NPU_CMD_STOP; return NPU_ERROR_TIMEOUT; }
     
     last_cycles = NPU->PMCCNTR_LO;
+    last_perf.axi_read_beats = NPU->PMEVCNTR[NPU_PMU_CNT_AXI_RD];
+    last_perf.axi_write_beats = NPU->PMEVCNTR[NPU_PMU_CNT_AXI_WR];
     
-    /* Demo: Simple heuristic-based scoring */
+    /* Demo: Simple heuristic-based scoring on channel 0 of the input */
     int32_t scores[10] = {0};
     int32_t total = 0, top = 0, bottom = 0, left = 0, right = 0, center = 0;
+    size_t stride = input_cfg.channels;
     
     for (size_t y = 0; y < 28; y++) {
         for (size_t x = 0; x < 28; x++) {
-            int val = input[y * 28 + x] + 128;
+            int val = slot[(y * 28 + x) * stride] + 128;
             total += val;
             if (y < 10) top += val;
             if (y > 17) bottom += val;
@@ -101,11 +188,16 @@ int npu_run_inference(const uint8_t* model_data, size_t model_size,
     }
     
     if (last_cycles == 0) last_cycles = 5000;
+    last_perf.cycles = last_cycles;
     return NPU_OK;
 }
 
 uint32_t npu_get_cycles(void) { return last_cycles; }
 
+void npu_get_perf(npu_perf_t* perf) {
+    if (perf) *perf = last_perf;
+}
+
 int argmax_int8(const int8_t* data, size_t size) {
     if (!data || size == 0) return -1;
     int max_idx = 0;
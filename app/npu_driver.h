@@ -17,11 +17,47 @@
 #define NPU_ERROR_INFERENCE -2
 #define NPU_ERROR_TIMEOUT   -3
 
+/* Input tensor layouts. Vela command streams read the graph input as NHWC,
+ * so npu_run_inference requires an NHWC slot; NHCWB16 slots can only be
+ * staged with npu_stage_input to measure packing cost. */
+#define NPU_LAYOUT_NHWC     0
+#define NPU_LAYOUT_NHCWB16  1   /* NPU native: [H][C/16][W][16] bricks */
+
+#define NPU_BRICK_DEPTH     16
+#define NPU_NHCWB16_SIZE(h, w, c) \
+    ((size_t)(h) * (size_t)(w) * \
+     ((((size_t)(c) + NPU_BRICK_DEPTH - 1) / NPU_BRICK_DEPTH) * NPU_BRICK_DEPTH))
+
+/* One AXI data beat on the Ethos-U55 64-bit interface */
+#define NPU_AXI_BEAT_BYTES  8
+
+typedef struct {
+    uint8_t slot_layout;    /* Layout of the input slot in the arena */
+    uint8_t source_layout;  /* Layout of buffers passed to npu_run_inference */
+    uint16_t height;
+    uint16_t width;
+    uint16_t channels;
+} npu_input_config_t;
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t axi_read_beats;
+    uint32_t axi_write_beats;
+} npu_perf_t;
+
 int npu_init(void);
+int npu_configure_input(const npu_input_config_t* cfg);
 int npu_run_inference(const uint8_t* model_data, size_t model_size,
                       const int8_t* input, size_t input_size,
                       int8_t* output, size_t output_size);
+size_t npu_stage_input(size_t model_size, const int8_t* input,
+                       size_t input_size);
 uint32_t npu_get_cycles(void);
+void npu_get_perf(npu_perf_t* perf);
+void npu_arena_reset_watermark(void);
+uint32_t npu_arena_high_water(void);
+void npu_nhwc_to_nhcwb16(const int8_t* src, int8_t* dst,
+                         size_t height, size_t width, size_t channels);
 int argmax_int8(const int8_t* data, size_t size);
 int calculate_confidence(const int8_t* scores, size_t size, int predicted_idx);
 
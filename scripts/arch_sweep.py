@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+MNIST Architecture Sweep for Ethos-U55
+======================================
+Trains a grid of CNN variants, compiles each with Vela (run_vela.sh and
+vela_config.ini), parses Vela's per-layer performance CSVs and reports the
+Pareto front of estimated NPU cycles, SRAM usage and INT8 accuracy.
+
+Grid axes:
+  --widths      conv channel widths, e.g. 8x16 (conv1 x conv2)
+  --blocks      conv (standard 3x3) or dwsep (depthwise 3x3 + pointwise 1x1)
+  --downsample  pool (2x2 max pool) or stride (stride-2 conv)
+  --input-sizes input resolution; 14 downsamples MNIST before the model
+
+Runs entirely offline on the CPU; no NPU or board is needed.
+"""
+
+import os
+os.environ.setdefault("CUDA_VISIBLE_DEVICES", "-1")
+
+import argparse
+import csv
+import itertools
+
+import numpy as np
+import tensorflow as tf
+
+import tflite_int8
+import vela_stats
+
+parser = argparse.ArgumentParser(description="Ethos-U55 architecture sweep")
+parser.add_argument("--widths", default="4x8,8x16,16x32")
+parser.add_argument("--blocks", default="conv,dwsep")
+parser.add_argument("--downsample", default="pool,stride")
+parser.add_argument("--input-sizes", default="28,14")
+parser.add_argument("--epochs", type=int, default=3)
+parser.add_argument("--eval-samples", type=int, default=1000,
+                    help="test images used for INT8 accuracy")
+parser.add_argument("--output-dir", default="../model/sweep")
+args = parser.parse_args()
+
+print("=" * 70)
+print("Architecture Sweep for Alif E8 Ethos-U55 NPU")
+print("=" * 70)
+print(f"TensorFlow version: {tf.__version__}")
+
+np.random.seed(42)
+tf.random.set_seed(42)
+
+###############################################################################
+# Dataset
+###############################################################################
+(x_train, y_train), (x_test, y_test) = tf.keras.datasets.mnist.load_data()
+x_train = np.expand_dims(x_train.astype("float32") / 255.0, axis=-1)
+x_test = np.expand_dims(x_test.astype("float32") / 255.0, axis=-1)
+x_test = x_test[:args.eval_samples]
+y_test = y_test[:args.eval_samples]
+
+_datasets = {}
+
+
+def dataset(size):
+    """Train/test images at the given input resolution (cached)."""
+    if size not in _datasets:
+        if size == 28:
+            _datasets[size] = (x_train, x_test)
+        else:
+            resize = lambda x: tf.image.resize(x, (size, size), method="area").numpy()
+            _datasets[size] = (resize(x_train), resize(x_test))
+    return _datasets[size]
+
+
+###############################################################################
+# Model Variants
+###############################################################################
+def conv_block(x, filters, block, downsample, name):
+    stride = 2 if downsample == "stride" else 1
+    if block == "dwsep" and x.shape[-1] > 1:
+        x = tf.keras.layers.DepthwiseConv2D(3, strides=stride, padding="same",
+                                            name=f"{name}_dw")(x)
+        x = tf.keras.layers.BatchNormalization(name=f"{name}_dw_bn")(x)
+        x = tf.keras.layers.ReLU(name=f"{name}_dw_relu")(x)
+        x = tf.keras.layers.Conv2D(filters, 1, name=f"{name}_pw")(x)
+    else:
+        # A depthwise conv on the single-channel input is just a 3x3 conv
+        x = tf.keras.layers.Conv2D(filters, 3, strides=stride, padding="same",
+                                   name=name)(x)
+    x = tf.keras.layers.BatchNormalization(name=f"{name}_bn")(x)
+    x = tf.keras.layers.ReLU(name=f"{name}_relu")(x)
+    if downsample == "pool":
+        x = tf.keras.layers.MaxPooling2D(2, name=f"{name}_pool")(x)
+    return x
+
+
+def build_model(cfg):
+    inputs = tf.keras.layers.Input(shape=(cfg['input'], cfg['input'], 1), name="input")
+    x = inputs
+    for i, filters in enumerate(cfg['widths']):
+        x = conv_block(x, filters, cfg['block'], cfg['downsample'], f"conv{i + 1}")
+    x = tf.keras.layers.Flatten(name="flatten")(x)
+    outputs = tf.keras.layers.Dense(10, name="output")(x)
+    return tf.keras.Model(inputs, outputs, name=cfg['name'])
+
+
+def pareto_front(rows):
+    """Rows not dominated on (cycles min, SRAM min, accuracy max)."""
+    def key(r):
+        return (r['npu_cycles'], r['sram_bytes'], -r['int8_accuracy'])
+
+    valid = [r for r in rows if r['npu_cycles'] is not None
+             and r['sram_bytes'] is not None]
+    front = []
+    for r in valid:
+        dominated = any(
+            all(a <= b for a, b in zip(key(o), key(r))) and key(o) != key(r)
+            for o in valid)
+        if not dominated:
+            front.append(r)
+    return sorted(front, key=lambda r: r['npu_cycles'])
+
+
+###############################################################################
+# Sweep
+###############################################################################
+grid = list(itertools.product(
+    [tuple(int(w) for w in spec.split("x")) for spec in args.widths.split(",")],
+    args.blocks.split(","),
+    args.downsample.split(","),
+    [int(s) for s in args.input_sizes.split(",")],
+))
+for _, block, down, _ in grid:
+    if block not in ("conv", "dwsep"):
+        raise SystemExit(f"ERROR: unknown block type '{block}'")
+    if down not in ("pool", "stride"):
+        raise SystemExit(f"ERROR: unknown downsample '{down}'")
+
+os.makedirs(args.output_dir, exist_ok=True)
+rows = []
+for n, (widths, block, down, size) in enumerate(grid, 1):
+    cfg = dict(widths=widths, block=block, downsample=down, input=size,
+               name=f"w{'x'.join(map(str, widths))}_{block}_{down}_in{size}")
+    print("\n" + "=" * 70)
+    print(f"[{n}/{len(grid)}] {cfg['name']}")
+    print("=" * 70)
+
+    train_images, test_images = dataset(size)
+    model = build_model(cfg)
+    model.compile(
+        optimizer=tf.keras.optimizers.Adam(learning_rate=0.001),
+        loss=tf.keras.losses.SparseCategoricalCrossentropy(from_logits=True),
+        metrics=['accuracy']
+    )
+    model.fit(train_images, y_train, batch_size=128, epochs=args.epochs,
+              validation_split=0.1, verbose=2)
+
+    tflite_model = tflite_int8.convert_to_int8_tflite(model, train_images)
+    accuracy, _, _ = tflite_int8.evaluate_int8(tflite_model, test_images, y_test)
+
+    variant_dir = os.path.join(args.output_dir, cfg['name'])
+    os.makedirs(variant_dir, exist_ok=True)
+    tflite_path = os.path.join(variant_dir, "mnist_model.tflite")
+    with open(tflite_path, "wb") as f:
+        f.write(tflite_model)
+
+    row = dict(variant=cfg['name'], widths="x".join(map(str, widths)),
+               block=block, downsample=down, input=size,
+               params=model.count_params(), tflite_bytes=len(tflite_model),
+               npu_cycles=None, sram_bytes=None, top_layer=None,
+               int8_accuracy=accuracy)
+    vela_dir = os.path.join(variant_dir, "vela")
+    try:
+        vela_stats.run_vela(tflite_path, vela_dir, per_layer=True)
+        summary = vela_stats.read_summary(vela_dir)
+        layers = vela_stats.summarize_per_layer(vela_stats.read_per_layer(vela_dir))
+        row['npu_cycles'] = summary['npu_cycles']
+        if summary['sram_used_kib'] is not None:
+            row['sram_bytes'] = summary['sram_used_kib'] * 1024
+        if layers:
+            row['top_layer'] = layers['top_layer']
+            if layers['cycles']:
+                row['npu_cycles'] = layers['cycles']
+            if layers['peak_sram_bytes']:
+                row['sram_bytes'] = layers['peak_sram_bytes']
+    except vela_stats.VelaError as e:
+        print(f"  Vela failed: {e}")
+    print(f"  INT8 accuracy: {accuracy:.4f}  NPU cycles: {row['npu_cycles']}  "
+          f"SRAM: {row['sram_bytes']}")
+    rows.append(row)
+
+###############################################################################
+# Report
+###############################################################################
+def write_csv(path, data):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(data)
+
+
+def fmt(v):
+    return "n/a" if v is None else f"{v:,.0f}"
+
+
+front = pareto_front(rows)
+write_csv(os.path.join(args.output_dir, "sweep_results.csv"), rows)
+write_csv(os.path.join(args.output_dir, "pareto_front.csv"), front)
+
+print("\n" + "=" * 70)
+print("PARETO FRONT (NPU cycles / SRAM / INT8 accuracy)")
+print("=" * 70)
+print(f"{'Variant':32s} {'NPU cycles':>11s} {'SRAM B':>9s} {'INT8 acc':>8s}  Top layer")
+for r in front:
+    print(f"{r['variant']:32s} {fmt(r['npu_cycles']):>11s} "
+          f"{fmt(r['sram_bytes']):>9s} {r['int8_accuracy']:8.4f}  {r['top_layer'] or ''}")
+print("=" * 70)
+print(f"{len(front)} of {len(rows)} variants on the front")
+print(f"All results: {os.path.join(args.output_dir, 'sweep_results.csv')}")
+print(f"Front:       {os.path.join(args.output_dir, 'pareto_front.csv')}")
+print("=" * 70)
@@ -10,6 +10,8 @@ import numpy as np
 import json
 from datetime import datetime
 
+import layer_codegen
+
 print("=" * 60)
 print("Generating C Headers for Embedded Deployment")
 print("=" * 60)
@@ -149,6 +151,27 @@ with open(f"{OUTPUT_DIR}/model_config.h", "w") as f:
 #endif /* MODEL_CONFIG_H */
 """)
 
+# Step 7: Generate per-layer descriptors and specialized CPU kernels
+print("Step 7: Generating model_layers.h and model_kernels.h...")
+stamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+try:
+    layers = layer_codegen.extract_layers(FALLBACK_MODEL_PATH)
+    with open(f"{OUTPUT_DIR}/model_layers.h", "w") as f:
+        layer_codegen.write_layers_header(f, layers, stamp)
+    with open(f"{OUTPUT_DIR}/model_kernels.h", "w") as f:
+        layer_codegen.write_kernels_header(f, layers, stamp)
+    for l in layers:
+        (ih, iw, ic), (oh, ow, oc) = l['in_shape'], l['out_shape']
+        print(f"  {l['name']:6s} {ih}x{iw}x{ic} -> {oh}x{ow}x{oc}")
+    layers_note = (f"{len(layers)} layers, "
+                   f"{layer_codegen.count_macs(layers):,} MACs")
+except (ImportError, OSError, layer_codegen.UnsupportedModel) as e:
+    print(f"  Note: CPU kernels disabled ({e})")
+    with open(f"{OUTPUT_DIR}/model_layers.h", "w") as fl, \
+         open(f"{OUTPUT_DIR}/model_kernels.h", "w") as fk:
+        layer_codegen.write_unsupported_headers(fl, fk, stamp, str(e))
+    layers_note = "CPU kernels disabled"
+
 print("\n" + "=" * 60)
 print("HEADER GENERATION COMPLETE")
 print("=" * 60)
@@ -156,5 +179,6 @@ print(f"\nGenerated files in {OUTPUT_DIR}/:")
 print(f"  - mnist_model_data.h ({len(model_data):,} bytes)")
 print(f"  - test_data.h (digit {test_label})")
 print(f"  - model_config.h")
+print(f"  - model_layers.h / model_kernels.h ({layers_note})")
 print("\nNext: cd .. && make all")
 print("=" * 60)
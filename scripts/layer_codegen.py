@@ -0,0 +1,537 @@
+#!/usr/bin/env python3
+"""
+Per-Layer Descriptor and Kernel Generation
+==========================================
+Reads the int8 TFLite model (before Vela) and emits:
+  - model_layers.h:  constant cpu_layer_t descriptors with shapes, strides,
+                     requantization multipliers/shifts and weight pointers
+  - model_kernels.h: CPU kernels specialized for each layer's exact
+                     dimensions, with small filters fully unrolled
+
+Used by generate_headers.py; see app/cpu_kernels.h for the C side.
+"""
+
+import math
+import numpy as np
+
+# Filters with at most this many MACs per output pixel are fully unrolled
+# with the weights as immediates; larger ones use constant-bound loops.
+UNROLL_MAX_MACS = 2048
+
+OP_CONV2D = "CPU_OP_CONV2D"
+OP_MAXPOOL2D = "CPU_OP_MAXPOOL2D"
+OP_FULLY_CONNECTED = "CPU_OP_FULLY_CONNECTED"
+
+
+class UnsupportedModel(Exception):
+    pass
+
+
+def quantize_multiplier(real):
+    """Split a real scale into a Q31 multiplier and a left shift."""
+    if real == 0.0:
+        return 0, 0
+    q, shift = math.frexp(real)
+    q_fixed = int(round(q * (1 << 31)))
+    if q_fixed == (1 << 31):
+        q_fixed //= 2
+        shift += 1
+    if shift < -31:
+        return 0, 0
+    if shift > 30:
+        raise UnsupportedModel(f"requantization scale {real} out of range")
+    return q_fixed, shift
+
+
+def _hwc(shape):
+    """Map a [1,H,W,C] or [1,K] tensor shape to (H, W, C)."""
+    shape = [int(d) for d in shape]
+    if len(shape) == 4:
+        return tuple(shape[1:])
+    if len(shape) == 2:
+        return (1, 1, shape[1])
+    raise UnsupportedModel(f"unsupported tensor rank {len(shape)}")
+
+
+def _window(in_dim, out_dim, filt):
+    """Infer stride and leading padding (SAME or VALID) for one axis."""
+    for stride in range(1, 5):
+        if -(-in_dim // stride) == out_dim:
+            total = max((out_dim - 1) * stride + filt - in_dim, 0)
+            return stride, total // 2
+        if (in_dim - filt) // stride + 1 == out_dim:
+            return stride, 0
+    raise UnsupportedModel(f"cannot infer stride for {in_dim}->{out_dim}")
+
+
+def _zero_point(tensor):
+    zps = tensor['quantization_parameters']['zero_points']
+    return int(zps[0]) if len(zps) else 0
+
+
+def _scale(tensor):
+    scales = tensor['quantization_parameters']['scales']
+    return float(scales[0]) if len(scales) else 0.0
+
+
+# TFLite ActivationFunctionType values
+ACT_NONE, ACT_RELU, ACT_RELU_N1_TO_1, ACT_RELU6 = 0, 1, 2, 3
+
+
+def fused_activations(model_path):
+    """Map each operator's output tensor index to its fused activation.
+
+    The interpreter does not expose builtin options, so read them from the
+    flatbuffer (subgraph 0 shares tensor indices with the interpreter).
+    """
+    try:
+        from tensorflow.lite.python import schema_py_generated as schema_fb
+    except ImportError as e:
+        raise UnsupportedModel(f"cannot read fused activations: {e}")
+
+    with open(model_path, "rb") as f:
+        buf = bytearray(f.read())
+    model = schema_fb.ModelT.InitFromObj(schema_fb.Model.GetRootAsModel(buf, 0))
+    acts = {}
+    for op in model.subgraphs[0].operators:
+        options = op.builtinOptions
+        if options is not None and hasattr(options, "fusedActivationFunction"):
+            acts[int(op.outputs[0])] = int(options.fusedActivationFunction)
+    return acts
+
+
+def _quantize(value, scale, zero_point):
+    """Quantize a real value, rounding half away from zero like TFLite."""
+    q = value / scale
+    return zero_point + int(math.copysign(math.floor(abs(q) + 0.5), q))
+
+
+def activation_range(activation, scale, zero_point):
+    """int8 clamp for a fused activation on the output quantization."""
+    if activation == ACT_NONE:
+        return -128, 127
+    if scale <= 0.0:
+        raise UnsupportedModel("fused activation on a tensor without a scale")
+    if activation == ACT_RELU:
+        lo, hi = _quantize(0.0, scale, zero_point), 127
+    elif activation == ACT_RELU6:
+        lo, hi = _quantize(0.0, scale, zero_point), _quantize(6.0, scale, zero_point)
+    elif activation == ACT_RELU_N1_TO_1:
+        lo, hi = _quantize(-1.0, scale, zero_point), _quantize(1.0, scale, zero_point)
+    else:
+        raise UnsupportedModel(f"fused activation {activation} has no CPU kernel")
+    return max(lo, -128), min(hi, 127)
+
+
+def extract_layers(model_path):
+    """Return a list of layer dicts for the CPU kernels."""
+    import tensorflow as tf
+
+    interp = tf.lite.Interpreter(model_path=model_path)
+    interp.allocate_tensors()
+    tensors = {t['index']: t for t in interp.get_tensor_details()}
+    activations = fused_activations(model_path)
+
+    layers = []
+    counts = {}
+    for op in interp._get_ops_details():
+        name = op['op_name']
+        inputs = [i for i in op['inputs'] if i >= 0]
+        t_in = tensors[inputs[0]]
+        t_out = tensors[op['outputs'][0]]
+        in_h, in_w, in_c = _hwc(t_in['shape'])
+        out_h, out_w, out_c = _hwc(t_out['shape'])
+
+        if name in ("RESHAPE", "SQUEEZE"):
+            continue   # NHWC flatten is a no-op on the buffer
+
+        if name not in ("CONV_2D", "FULLY_CONNECTED", "MAX_POOL_2D"):
+            raise UnsupportedModel(f"operator {name} has no CPU kernel")
+        out_index = op['outputs'][0]
+        if out_index not in activations:
+            raise UnsupportedModel(f"no fused activation found for {name}")
+        act_min, act_max = activation_range(activations[out_index], _scale(t_out),
+                                            _zero_point(t_out))
+        layer = dict(in_shape=(in_h, in_w, in_c), out_shape=(out_h, out_w, out_c),
+                     in_zp=_zero_point(t_in), out_zp=_zero_point(t_out),
+                     act_min=act_min, act_max=act_max, weights=None, bias=None,
+                     multiplier=None, shift=None)
+
+        if name == "CONV_2D":
+            t_w = tensors[inputs[1]]
+            weights = interp.get_tensor(inputs[1]).astype(np.int8)
+            _, kh, kw, _ = weights.shape
+            layer['op'] = OP_CONV2D
+            layer['filter'] = (kh, kw)
+        elif name == "FULLY_CONNECTED":
+            t_w = tensors[inputs[1]]
+            weights = interp.get_tensor(inputs[1]).astype(np.int8)
+            layer['op'] = OP_FULLY_CONNECTED
+            layer['filter'] = (1, 1)
+            layer['in_shape'] = (1, 1, in_h * in_w * in_c)
+        elif name == "MAX_POOL_2D":
+            # Pool size is not exposed by the interpreter; Keras pools use
+            # pool_size == strides, so infer it from the shape ratio.
+            sh, sw = max(in_h // out_h, 1), max(in_w // out_w, 1)
+            layer['op'] = OP_MAXPOOL2D
+            layer['filter'] = (sh, sw)
+            layer['stride'] = (sh, sw)
+            layer['pad'] = (0, 0)
+            layers.append(layer)
+            continue
+
+        # Per-channel (conv) or per-tensor (FC) requantization
+        w_scales = t_w['quantization_parameters']['scales']
+        if len(w_scales) == 1:
+            w_scales = np.repeat(w_scales, out_c)
+        in_scale, out_scale = _scale(t_in), _scale(t_out)
+        mults, shifts = zip(*(quantize_multiplier(in_scale * float(s) / out_scale)
+                              for s in w_scales))
+
+        bias = np.zeros(out_c, dtype=np.int32)
+        if len(inputs) > 2:
+            bias = interp.get_tensor(inputs[2]).astype(np.int32)
+
+        layer['weights'] = weights.reshape(out_c, -1)
+        layer['bias'] = bias
+        layer['multiplier'] = list(mults)
+        layer['shift'] = list(shifts)
+        if layer['op'] == OP_CONV2D:
+            kh, kw = layer['filter']
+            sh, ph = _window(in_h, out_h, kh)
+            sw, pw = _window(in_w, out_w, kw)
+            layer['stride'] = (sh, sw)
+            layer['pad'] = (ph, pw)
+        else:
+            layer['stride'] = (1, 1)
+            layer['pad'] = (0, 0)
+        layers.append(layer)
+
+    for layer in layers:
+        kind = {OP_CONV2D: "conv", OP_MAXPOOL2D: "pool",
+                OP_FULLY_CONNECTED: "fc"}[layer['op']]
+        counts[kind] = counts.get(kind, 0) + 1
+        layer['name'] = f"{kind}{counts[kind]}"
+    if not layers:
+        raise UnsupportedModel("model has no layers")
+    return layers
+
+
+def _padded_dims(layer):
+    """Rows/cols of the input window the kernel touches, incl. padding."""
+    (oh, ow, _), (kh, kw) = layer['out_shape'], layer['filter']
+    sh, sw = layer['stride']
+    return (oh - 1) * sh + kh, (ow - 1) * sw + kw
+
+
+def _needs_pad(layer):
+    ih, iw, _ = layer['in_shape']
+    ph, pw = _padded_dims(layer)
+    return layer['pad'] != (0, 0) or ph > ih or pw > iw
+
+
+def _c_array(ctype, name, values, per_line=16):
+    values = [int(v) for v in values]
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i + per_line]))
+    return (f"static const {ctype} {name}[{len(values)}] = {{\n"
+            + ",\n".join(lines) + "\n};\n")
+
+
+def sizes(layers):
+    act = max(int(np.prod(l['out_shape'])) for l in layers)
+    pad = 1
+    for l in layers:
+        if l['op'] == OP_CONV2D and _needs_pad(l):
+            ph, pw = _padded_dims(l)
+            pad = max(pad, ph * pw * l['in_shape'][2])
+    weights = sum(l['weights'].size for l in layers if l['weights'] is not None)
+    # Round scratch up to 16 bytes so each buffer stays word-aligned
+    return (act + 15) & ~15, (pad + 15) & ~15, weights
+
+
+def write_layers_header(f, layers, stamp):
+    act, pad, weight_bytes = sizes(layers)
+    f.write(f"""/**
+ * @file model_layers.h
+ * @brief Per-layer descriptors for the CPU kernels
+ * Auto-generated on {stamp}
+ */
+
+#ifndef MODEL_LAYERS_H
+#define MODEL_LAYERS_H
+
+#include <stdint.h>
+#include "cpu_kernels.h"
+
+#define CPU_LAYERS_SUPPORTED   1
+#define CPU_NUM_LAYERS         {len(layers)}
+#define CPU_INPUT_SIZE         {int(np.prod(layers[0]['in_shape']))}
+#define CPU_OUTPUT_SIZE        {int(np.prod(layers[-1]['out_shape']))}
+#define CPU_ACT_SIZE           {act}
+#define CPU_PAD_SIZE           {pad}
+#define CPU_WEIGHT_BYTES       {weight_bytes}
+
+""")
+    for l in layers:
+        if l['weights'] is None:
+            continue
+        n = l['name']
+        f.write(_c_array("int8_t", f"{n}_weights", l['weights'].flatten()))
+        f.write(_c_array("int32_t", f"{n}_bias", l['bias'], 8))
+        f.write(_c_array("int32_t", f"{n}_multiplier", l['multiplier'], 8))
+        f.write(_c_array("int32_t", f"{n}_shift", l['shift'], 8))
+        f.write("\n")
+
+    f.write("static const cpu_layer_t cpu_layers[CPU_NUM_LAYERS] = {\n")
+    for l in layers:
+        n = l['name']
+        (ih, iw, ic), (oh, ow, oc) = l['in_shape'], l['out_shape']
+        has_w = l['weights'] is not None
+        f.write(f"""    {{   /* {n}: {ih}x{iw}x{ic} -> {oh}x{ow}x{oc} */
+        .op = {l['op']},
+        .in_h = {ih}, .in_w = {iw}, .in_c = {ic},
+        .out_h = {oh}, .out_w = {ow}, .out_c = {oc},
+        .filter_h = {l['filter'][0]}, .filter_w = {l['filter'][1]},
+        .stride_h = {l['stride'][0]}, .stride_w = {l['stride'][1]},
+        .pad_top = {l['pad'][0]}, .pad_left = {l['pad'][1]},
+        .in_zp = {l['in_zp']}, .out_zp = {l['out_zp']},
+        .act_min = {l['act_min']}, .act_max = {l['act_max']},
+        .weights = {f"{n}_weights" if has_w else "NULL"},
+        .bias = {f"{n}_bias" if has_w else "NULL"},
+        .multiplier = {f"{n}_multiplier" if has_w else "NULL"},
+        .shift = {f"{n}_shift" if has_w else "NULL"},
+    }},
+""")
+    f.write("""};
+
+#endif /* MODEL_LAYERS_H */
+""")
+
+
+def write_unsupported_headers(f_layers, f_kernels, stamp, reason):
+    f_layers.write(f"""/**
+ * @file model_layers.h
+ * @brief Per-layer descriptors for the CPU kernels
+ * Auto-generated on {stamp}
+ *
+ * CPU kernels unavailable: {reason}
+ */
+
+#ifndef MODEL_LAYERS_H
+#define MODEL_LAYERS_H
+
+#include <stdint.h>
+#include "cpu_kernels.h"
+
+#define CPU_LAYERS_SUPPORTED   0
+#define CPU_NUM_LAYERS         0
+#define CPU_INPUT_SIZE         1
+#define CPU_OUTPUT_SIZE        1
+#define CPU_ACT_SIZE           16
+#define CPU_PAD_SIZE           16
+#define CPU_WEIGHT_BYTES       0
+
+static const cpu_layer_t cpu_layers[1];
+
+#endif /* MODEL_LAYERS_H */
+""")
+    f_kernels.write(f"""/**
+ * @file model_kernels.h
+ * @brief Specialized CPU kernels (unavailable for this model)
+ * Auto-generated on {stamp}
+ */
+
+#ifndef MODEL_KERNELS_H
+#define MODEL_KERNELS_H
+
+CPU_SPEC_KERNEL
+static void cpu_spec_run(const int8_t* in, int8_t* out) {{
+    (void)in; (void)out; (void)cpu_act; (void)cpu_pad_buf;
+}}
+
+#endif /* MODEL_KERNELS_H */
+""")
+
+
+def _mac_terms(weights, taps, var="v"):
+    """Sum of v<k> * w for the non-zero weights of one output channel."""
+    return [f"{var}{k} * {int(w)}" for k, w in zip(range(taps), weights) if w != 0]
+
+
+def _emit_conv(l, idx):
+    n = l['name']
+    (ih, iw, ic), (oh, ow, oc) = l['in_shape'], l['out_shape']
+    kh, kw = l['filter']
+    sh, sw = l['stride']
+    taps = kh * kw * ic
+    w = l['weights'].astype(np.int32)
+    # Fold the input zero point into the bias: sum((x - zp) * w) =
+    # sum(x * w) - zp * sum(w). Padding with zp then contributes nothing.
+    folded = l['bias'].astype(np.int64) - l['in_zp'] * w.sum(axis=1)
+    rq = f"{n}_multiplier[{{oc}}], {n}_shift[{{oc}}], {l['out_zp']}, {l['act_min']}, {l['act_max']}"
+
+    out = [f"/* {n}: {ih}x{iw}x{ic} -> {oh}x{ow}x{oc}, "
+           f"{kh}x{kw} stride {sh}x{sw} */"]
+    unrolled = taps * oc <= UNROLL_MAX_MACS
+    if not unrolled:
+        out.append(_c_array("int32_t", f"{n}_bias_folded", folded, 8).rstrip())
+    out.append("CPU_SPEC_KERNEL")
+    out.append(f"static void spec_{n}(const int8_t* in, int8_t* out) {{")
+
+    if _needs_pad(l):
+        ph, pw = _padded_dims(l)
+        rows = min(ih, ph - l['pad'][0])
+        cols = min(iw, pw - l['pad'][1])
+        src_w = pw
+        out.append(f"    int8_t* src = cpu_pad_buf;")
+        out.append(f"    memset(src, {l['in_zp']}, {ph * pw * ic});")
+        out.append(f"    for (int y = 0; y < {rows}; y++) {{")
+        out.append(f"        memcpy(src + ((y + {l['pad'][0]}) * {pw} + {l['pad'][1]}) * {ic},")
+        out.append(f"               in + y * {iw * ic}, {cols * ic});")
+        out.append("    }")
+    else:
+        src_w = iw
+        out.append("    const int8_t* src = in;")
+
+    out.append(f"    for (int y = 0; y < {oh}; y++) {{")
+    out.append(f"        for (int x = 0; x < {ow}; x++) {{")
+    out.append(f"            const int8_t* p = src + (y * {sh * src_w} + x * {sw}) * {ic};")
+    out.append(f"            int8_t* o = out + (y * {ow} + x) * {oc};")
+
+    if unrolled:
+        offsets = [(ky * src_w + kx) * ic + c
+                   for ky in range(kh) for kx in range(kw) for c in range(ic)]
+        used = np.any(w != 0, axis=0)
+        for k, off in enumerate(offsets):
+            if used[k]:
+                out.append(f"            const int32_t v{k} = p[{off}];")
+        for c in range(oc):
+            terms = _mac_terms(w[c], taps)
+            expr = f"{int(folded[c])}"
+            for i in range(0, len(terms), 6):
+                expr += "\n                + " + " + ".join(terms[i:i + 6])
+            out.append(f"            o[{c}] = cpu_requant_s8({expr},")
+            out.append(f"                {rq.format(oc=c)});")
+    else:
+        out.append(f"            for (int oc = 0; oc < {oc}; oc++) {{")
+        out.append(f"                const int8_t* wk = {n}_weights + oc * {taps};")
+        out.append(f"                int32_t acc = {n}_bias_folded[oc];")
+        out.append(f"                for (int ky = 0; ky < {kh}; ky++) {{")
+        out.append(f"                    const int8_t* row = p + ky * {src_w * ic};")
+        out.append(f"                    #pragma GCC unroll {min(kw * ic, 16)}")
+        out.append(f"                    for (int k = 0; k < {kw * ic}; k++) {{")
+        out.append(f"                        acc += row[k] * wk[ky * {kw * ic} + k];")
+        out.append("                    }")
+        out.append("                }")
+        out.append(f"                o[oc] = cpu_requant_s8(acc, {rq.format(oc='oc')});")
+        out.append("            }")
+    out.append("        }")
+    out.append("    }")
+    out.append("}")
+    return "\n".join(out)
+
+
+def _emit_maxpool(l, idx):
+    n = l['name']
+    (ih, iw, ic), (oh, ow, oc) = l['in_shape'], l['out_shape']
+    kh, kw = l['filter']
+    sh, sw = l['stride']
+    out = [f"/* {n}: {ih}x{iw}x{ic} -> {oh}x{ow}x{oc}, {kh}x{kw} stride {sh}x{sw} */",
+           "CPU_SPEC_KERNEL",
+           f"static void spec_{n}(const int8_t* in, int8_t* out) {{"]
+    if _needs_pad(l):
+        out.append(f"    cpu_maxpool2d_s8(&cpu_layers[{idx}], in, out);")
+        out.append("}")
+        return "\n".join(out)
+    out.append(f"    for (int y = 0; y < {oh}; y++) {{")
+    out.append(f"        for (int x = 0; x < {ow}; x++) {{")
+    out.append(f"            const int8_t* p = in + (y * {sh * iw} + x * {sw}) * {ic};")
+    out.append(f"            int8_t* o = out + (y * {ow} + x) * {oc};")
+    out.append(f"            for (int c = 0; c < {oc}; c++) {{")
+    out.append(f"                int32_t m = p[c];")
+    for ky in range(kh):
+        for kx in range(kw):
+            if ky == 0 and kx == 0:
+                continue
+            out.append(f"                if (p[{(ky * iw + kx) * ic} + c] > m) "
+                       f"m = p[{(ky * iw + kx) * ic} + c];")
+    if l['act_min'] > -128:
+        out.append(f"                if (m < {l['act_min']}) m = {l['act_min']};")
+    if l['act_max'] < 127:
+        out.append(f"                if (m > {l['act_max']}) m = {l['act_max']};")
+    out.append("                o[c] = (int8_t)m;")
+    out.append("            }")
+    out.append("        }")
+    out.append("    }")
+    out.append("}")
+    return "\n".join(out)
+
+
+def _emit_fc(l, idx):
+    n = l['name']
+    depth, oc = l['in_shape'][2], l['out_shape'][2]
+    w = l['weights'].astype(np.int32)
+    folded = l['bias'].astype(np.int64) - l['in_zp'] * w.sum(axis=1)
+    out = [f"/* {n}: {depth} -> {oc} */",
+           _c_array("int32_t", f"{n}_bias_folded", folded, 8).rstrip(),
+           "CPU_SPEC_KERNEL",
+           f"static void spec_{n}(const int8_t* in, int8_t* out) {{",
+           f"    for (int oc = 0; oc < {oc}; oc++) {{",
+           f"        const int8_t* wk = {n}_weights + oc * {depth};",
+           f"        int32_t acc = {n}_bias_folded[oc];",
+           f"        #pragma GCC unroll 16",
+           f"        for (int i = 0; i < {depth}; i++) {{",
+           f"            acc += in[i] * wk[i];",
+           "        }",
+           f"        out[oc] = cpu_requant_s8(acc, {n}_multiplier[oc], {n}_shift[oc],",
+           f"                                 {l['out_zp']}, {l['act_min']}, {l['act_max']});",
+           "    }",
+           "}"]
+    return "\n".join(out)
+
+
+def write_kernels_header(f, layers, stamp):
+    f.write(f"""/**
+ * @file model_kernels.h
+ * @brief CPU kernels specialized for each layer's exact dimensions
+ * Auto-generated on {stamp}
+ *
+ * Included by cpu_kernels.c after cpu_act/cpu_pad_buf are declared.
+ * Filters up to {UNROLL_MAX_MACS} MACs per pixel are fully unrolled with the
+ * weights as immediates (zero weights are skipped).
+ */
+
+#ifndef MODEL_KERNELS_H
+#define MODEL_KERNELS_H
+
+#include <string.h>
+
+""")
+    emit = {OP_CONV2D: _emit_conv, OP_MAXPOOL2D: _emit_maxpool,
+            OP_FULLY_CONNECTED: _emit_fc}
+    for idx, l in enumerate(layers):
+        f.write(emit[l['op']](l, idx))
+        f.write("\n\n")
+
+    f.write("CPU_SPEC_KERNEL\n")
+    f.write("static void cpu_spec_run(const int8_t* in, int8_t* out) {\n")
+    f.write("    (void)cpu_pad_buf;\n")
+    src = "in"
+    for i, l in enumerate(layers):
+        dst = "out" if i == len(layers) - 1 else f"cpu_act[{i & 1}]"
+        f.write(f"    spec_{l['name']}({src}, {dst});\n")
+        src = dst
+    f.write("""}
+
+#endif /* MODEL_KERNELS_H */
+""")
+
+
+def count_macs(layers):
+    total = 0
+    for l in layers:
+        if l['weights'] is not None:
+            total += int(np.prod(l['out_shape'])) * l['weights'].shape[1]
+    return total
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+"""
+Memory Budget Report
+====================
+Parses the GNU ld map file (build/mnist_npu_demo.map) into a per-region,
+per-section and per-symbol budget table and checks it against limits.
+
+Usage:
+  python mem_report.py [MAP] [--elf ELF] [--limit SRAM0=160K]
+                       [--symbol-limit tensor_arena=96K] [--top 20]
+
+Exits with status 1 if any limit is exceeded.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+DEFAULT_MAP = "../build/mnist_npu_demo.map"
+
+HEX = r"0x[0-9a-fA-F]+"
+RE_REGION = re.compile(rf"^(\S+)\s+({HEX})\s+({HEX})(?:\s+(\S+))?\s*$")
+RE_OUTPUT = re.compile(rf"^(\.\S+)\s+({HEX})\s+({HEX})(?:\s+load address\s+({HEX}))?\s*$")
+RE_OUTPUT_NAME = re.compile(r"^(\.\S+)\s*$")
+RE_OUTPUT_TAIL = re.compile(rf"^\s+({HEX})\s+({HEX})(?:\s+load address\s+({HEX}))?\s*$")
+RE_INPUT = re.compile(rf"^ (\S+)\s+({HEX})\s+({HEX})\s+(\S.*)$")
+RE_INPUT_NAME = re.compile(r"^ (\S+)\s*$")
+RE_INPUT_TAIL = re.compile(rf"^\s+({HEX})\s+({HEX})\s+(\S.*)$")
+RE_SYMBOL = re.compile(rf"^\s+({HEX})\s+([A-Za-z_][A-Za-z0-9_.$]*)\s*$")
+
+# Sections that never occupy target memory
+IGNORED_SECTIONS = (".ARM.attributes", ".comment", ".debug")
+
+# Sections without contents, used when no ELF is available. GNU ld still
+# prints a load address for them when they follow an AT> section.
+NO_CONTENTS_SECTIONS = (".bss", ".sbss", ".noinit", ".tensor_arena", "._user_",
+                        "COMMON")
+
+SHT_NOBITS = 8
+
+
+def parse_size(text):
+    """Parse 128K / 1M / 0x2000 / 4096 into bytes."""
+    text = text.strip().upper()
+    mult = 1
+    if text.endswith("K"):
+        mult, text = 1024, text[:-1]
+    elif text.endswith("M"):
+        mult, text = 1024 * 1024, text[:-1]
+    return int(text, 0) * mult
+
+
+def parse_limits(items, what):
+    limits = {}
+    for item in items or []:
+        if "=" not in item:
+            raise SystemExit(f"ERROR: {what} limit '{item}' must be NAME=SIZE")
+        name, size = item.split("=", 1)
+        limits[name] = parse_size(size)
+    return limits
+
+
+def parse_map(path):
+    """Return (regions, output_sections, input_sections) from a map file."""
+    with open(path, "r", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    regions = []
+    outputs = []
+    inputs = []
+    mode = None
+    current = None
+    pending_out = None
+    pending_in = None
+
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            mode = "memory"
+            continue
+        if line.startswith("Linker script and memory map"):
+            mode = "map"
+            continue
+        if line.startswith("Cross Reference Table"):
+            break
+        if mode == "memory":
+            m = RE_REGION.match(line)
+            if m and m.group(1) not in ("Name", "*default*"):
+                regions.append(dict(name=m.group(1), origin=int(m.group(2), 16),
+                                    length=int(m.group(3), 16), used=0))
+            continue
+        if mode != "map":
+            continue
+
+        # Output sections (names of 15+ chars wrap onto the next line)
+        if pending_out is not None:
+            m = RE_OUTPUT_TAIL.match(line)
+            pending_name, pending_out = pending_out, None
+            if m:
+                current = _add_output(outputs, pending_name, m.group(1),
+                                      m.group(2), m.group(3))
+                continue
+        m = RE_OUTPUT.match(line)
+        if m:
+            current = _add_output(outputs, m.group(1), m.group(2), m.group(3),
+                                  m.group(4))
+            continue
+        m = RE_OUTPUT_NAME.match(line)
+        if m:
+            pending_out = m.group(1)
+            continue
+
+        # Input sections inside the current output section
+        if current is None:
+            continue
+        m = RE_SYMBOL.match(line)
+        if m:
+            # First global symbol defined in the preceding input section
+            if inputs and inputs[-1]['symbol'] is None and \
+                    int(m.group(1), 16) == inputs[-1]['addr']:
+                inputs[-1]['symbol'] = m.group(2)
+            continue
+        if pending_in is not None:
+            m = RE_INPUT_TAIL.match(line)
+            pending_name, pending_in = pending_in, None
+            if m:
+                _add_input(inputs, current, pending_name, m.group(1),
+                           m.group(2), m.group(3))
+                continue
+        m = RE_INPUT.match(line)
+        if m:
+            _add_input(inputs, current, m.group(1), m.group(2), m.group(3),
+                       m.group(4))
+            continue
+        m = RE_INPUT_NAME.match(line)
+        if m and not m.group(1).startswith("*"):
+            pending_in = m.group(1)
+
+    return regions, outputs, inputs
+
+
+def _add_output(outputs, name, addr, size, load):
+    sec = dict(name=name, addr=int(addr, 16), size=int(size, 16),
+               load=int(load, 16) if load else None)
+    outputs.append(sec)
+    return sec
+
+
+def _add_input(inputs, output, name, addr, size, obj):
+    size = int(size, 16)
+    if size == 0 or name.startswith("*"):
+        return
+    inputs.append(dict(section=name, output=output['name'], addr=int(addr, 16),
+                       size=size, obj=obj.strip(), symbol=None))
+
+
+def elf_nobits_sections(path):
+    """Names of SHT_NOBITS (no file contents) sections in an ELF file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise SystemExit(f"ERROR: {path} is not an ELF file")
+    is64 = data[4] == 2
+    end = "<" if data[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", data, 0x3A)
+    else:
+        shoff, = struct.unpack_from(end + "I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", data, 0x2E)
+
+    def header(i):
+        base = shoff + i * shentsize
+        name, sh_type = struct.unpack_from(end + "II", data, base)
+        off_fmt, off_pos = ("QQ", base + 0x18) if is64 else ("II", base + 0x10)
+        offset, size = struct.unpack_from(end + off_fmt, data, off_pos)
+        return name, sh_type, offset, size
+
+    _, _, str_off, str_size = header(shstrndx)
+    strtab = data[str_off:str_off + str_size]
+    names = set()
+    for i in range(shnum):
+        name, sh_type, _, _ = header(i)
+        if sh_type == SHT_NOBITS:
+            names.add(strtab[name:strtab.index(b"\0", name)].decode())
+    return names
+
+
+def has_contents(section, nobits):
+    """True if the section occupies space in its load region."""
+    if nobits is not None:
+        return section['name'] not in nobits
+    return not section['name'].startswith(NO_CONTENTS_SECTIONS)
+
+
+def region_of(regions, addr):
+    for r in regions:
+        if r['origin'] <= addr < r['origin'] + r['length']:
+            return r
+    return None
+
+
+# Input sections holding a single buffer that is named after it
+SECTION_SYMBOLS = {".tensor_arena": "tensor_arena"}
+
+
+def symbol_name(entry):
+    """.text.main -> main, .bss.cpu_act -> cpu_act, .tensor_arena -> tensor_arena."""
+    section = entry['section']
+    for prefix in (".text.", ".rodata.", ".data.", ".bss.", ".tensor_arena."):
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    if section in SECTION_SYMBOLS:
+        return SECTION_SYMBOLS[section]
+    if entry['symbol']:
+        return entry['symbol']
+    return f"{section} ({entry['obj'].split('/')[-1]})"
+
+
+def fmt(n):
+    return f"{n:,}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("map", nargs="?", default=DEFAULT_MAP)
+    parser.add_argument("--elf", help="ELF for section types (default: MAP with "
+                                      ".elf extension, if present)")
+    parser.add_argument("--limit", action="append", metavar="REGION=SIZE",
+                        help="budget for a memory region (e.g. SRAM0=160K)")
+    parser.add_argument("--symbol-limit", action="append", metavar="SYMBOL=SIZE",
+                        help="budget for a single symbol (e.g. tensor_arena=96K)")
+    parser.add_argument("--top", type=int, default=20,
+                        help="number of largest symbols to list")
+    args = parser.parse_args()
+
+    region_limits = parse_limits(args.limit, "region")
+    symbol_limits = parse_limits(args.symbol_limit, "symbol")
+    regions, outputs, inputs = parse_map(args.map)
+    if not regions:
+        raise SystemExit(f"ERROR: no Memory Configuration found in {args.map}")
+    elf = args.elf or os.path.splitext(args.map)[0] + ".elf"
+    if args.elf and not os.path.exists(elf):
+        raise SystemExit(f"ERROR: ELF file {elf} not found")
+    nobits = elf_nobits_sections(elf) if os.path.exists(elf) else None
+
+    # Attribute each output section to its run (and load) region
+    for sec in outputs:
+        sec['region'] = None
+        if sec['size'] == 0 or sec['name'].startswith(IGNORED_SECTIONS):
+            continue
+        run = region_of(regions, sec['addr'])
+        if run:
+            run['used'] += sec['size']
+            sec['region'] = run['name']
+        if sec['load'] is not None and sec['load'] != sec['addr'] and \
+                has_contents(sec, nobits):
+            load = region_of(regions, sec['load'])
+            if load and load is not run:
+                load['used'] += sec['size']
+                sec['region'] = f"{sec['region']} (load {load['name']})"
+
+    failures = []
+    print("=" * 70)
+    print(f"MEMORY BUDGET: {args.map}")
+    print("=" * 70)
+    print(f"{'Region':10s} {'Used':>10s} {'Size':>10s} {'Limit':>10s} {'Use%':>6s}  Status")
+    for r in regions:
+        limit = region_limits.get(r['name'], r['length'])
+        status = "OK"
+        if r['used'] > limit:
+            status = "OVER"
+            failures.append(f"region {r['name']}: {fmt(r['used'])} > {fmt(limit)}")
+        pct = 100.0 * r['used'] / limit if limit else 0.0
+        print(f"{r['name']:10s} {fmt(r['used']):>10s} {fmt(r['length']):>10s} "
+              f"{fmt(limit):>10s} {pct:5.1f}%  {status}")
+    for name in region_limits:
+        if name not in {r['name'] for r in regions}:
+            failures.append(f"region {name}: not in map file")
+
+    print("\n" + "-" * 70)
+    print(f"{'Section':20s} {'Address':>12s} {'Size':>10s}  Region")
+    for sec in outputs:
+        if sec['region'] is None:
+            continue
+        print(f"{sec['name']:20s} 0x{sec['addr']:08X} {fmt(sec['size']):>10s}  "
+              f"{sec['region']}")
+
+    symbols = {}
+    for i in inputs:
+        if i['output'].startswith(IGNORED_SECTIONS):
+            continue
+        name = symbol_name(i)
+        entry = symbols.setdefault(name, dict(size=0, output=i['output'],
+                                              obj=i['obj']))
+        entry['size'] += i['size']
+
+    print("\n" + "-" * 70)
+    print(f"Top {args.top} symbols")
+    print(f"{'Symbol':36s} {'Size':>10s}  {'Section':14s} Object")
+    ranked = sorted(symbols.items(), key=lambda kv: kv[1]['size'], reverse=True)
+    for name, s in ranked[:args.top]:
+        print(f"{name[:36]:36s} {fmt(s['size']):>10s}  {s['output']:14s} "
+              f"{s['obj'].split('/')[-1]}")
+
+    for name, limit in symbol_limits.items():
+        if name not in symbols:
+            failures.append(f"symbol {name}: not in map file")
+        elif symbols[name]['size'] > limit:
+            failures.append(f"symbol {name}: {fmt(symbols[name]['size'])} > {fmt(limit)}")
+
+    print("=" * 70)
+    if failures:
+        print("BUDGET EXCEEDED:")
+        for f in failures:
+            print(f"  - {f}")
+        return 1
+    print("All budgets met.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
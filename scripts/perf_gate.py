@@ -0,0 +1,386 @@
+#!/usr/bin/env python3
+"""
+Performance Regression Gate
+===========================
+Parses benchmark output (menu command 'b' in the firmware) and the linker
+map into metrics, keeps a history keyed by git commit and compares against
+a stored baseline with noise-aware thresholds.
+
+Benchmark output comes from a captured RTT log (--log, e.g. from
+JLinkRTTLogger) or from the stdout of any runner command (--run).
+
+Usage:
+  python perf_gate.py record   --log rtt.log [--map MAP | --no-map]
+  python perf_gate.py baseline [--commit SHA]
+  python perf_gate.py check    --log rtt.log [--map MAP | --no-map]
+
+check records the run and exits with status 1 on any regression or on any
+baseline metric missing from the run.
+"""
+
+import argparse
+import json
+import os
+import re
+import shlex
+import statistics
+import subprocess
+import sys
+import time
+
+import mem_report
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(SCRIPT_DIR)
+DEFAULT_MAP = os.path.join(REPO_DIR, "build", "mnist_npu_demo.map")
+DEFAULT_HISTORY = os.path.join(REPO_DIR, "perf", "history.jsonl")
+DEFAULT_BASELINE = os.path.join(REPO_DIR, "perf", "baseline.json")
+
+# Regression thresholds: a metric regresses when it is worse than the
+# baseline by more than max(rel * baseline, sigma * stdev, abs).
+TIMING = dict(rel=0.05, sigma=3.0, abs=0)
+SIZE = dict(rel=0.0, sigma=0.0, abs=64)
+EXACT = dict(rel=0.0, sigma=0.0, abs=0)
+
+METRICS = {
+    "npu_cycles":           dict(better="lower", **TIMING),
+    "avg_inference_us":     dict(better="lower", **TIMING),
+    "single_inference_us":  dict(better="lower", **TIMING),
+    "throughput_fps":       dict(better="higher", **TIMING),
+    "npu_axi_read_bytes":   dict(better="lower", **SIZE),
+    "npu_axi_write_bytes":  dict(better="lower", **SIZE),
+    "cpu_generic_cycles":   dict(better="lower", **TIMING),
+    "cpu_spec_cycles":      dict(better="lower", **TIMING),
+    "cpu_generic_code_bytes": dict(better="lower", **SIZE),
+    "cpu_spec_code_bytes":  dict(better="lower", **SIZE),
+    "model_bytes":          dict(better="lower", **EXACT),
+    "peak_arena_bytes":     dict(better="lower", **EXACT),
+    "peak_stack_bytes":     dict(better="lower", **SIZE),
+    "text_bytes":           dict(better="lower", **SIZE),
+    "rodata_bytes":         dict(better="lower", **SIZE),
+    "data_bytes":           dict(better="lower", **SIZE),
+    "bss_bytes":            dict(better="lower", **SIZE),
+    "tensor_arena_bytes":   dict(better="lower", **EXACT),
+}
+# Per-configuration input slot packing metrics, e.g. packing_nhcwb16_nhwc_cycles
+PACKING_METRICS = {
+    "_cycles":     dict(better="lower", **TIMING),
+    "_slot_bytes": dict(better="lower", **EXACT),
+}
+
+
+def metric_spec(name):
+    if name in METRICS:
+        return METRICS[name]
+    if name.startswith("packing_"):
+        for suffix, spec in PACKING_METRICS.items():
+            if name.endswith(suffix):
+                return spec
+    return None
+
+
+###############################################################################
+# Parsing
+###############################################################################
+RE_UINT = r"(\d+)"
+SUITE_BEGIN = "=== BENCHMARK SUITE BEGIN ==="
+SUITE_END = "=== BENCHMARK SUITE END ==="
+
+
+def suite_blocks(text):
+    """Lines of each benchmark suite run; the whole log if none is marked."""
+    lines = [raw.rstrip("\r").rstrip() for raw in text.splitlines()]
+    blocks = []
+    current = None
+    for line in lines:
+        if line.strip() == SUITE_BEGIN:
+            current = []
+        elif line.strip() == SUITE_END and current is not None:
+            blocks.append(current)
+            current = None
+        elif current is not None:
+            current.append(line)
+    return blocks or [lines]
+
+
+def parse_benchmark_log(text):
+    """Return {metric: [samples]} from firmware benchmark output.
+
+    Every suite run in the log contributes one sample per metric.
+    """
+    samples = {}
+
+    def add(name, value):
+        samples.setdefault(name, []).append(float(value))
+
+    for block in suite_blocks(text):
+        section = None
+        layout = None
+        path = None
+        arena_peak = None
+        prev = ""
+        for line in block:
+            stripped = line.strip()
+            # Section titles sit unindented between two '=====' rules
+            if prev.startswith("====") and line and not line[0].isspace() \
+                    and not line.startswith("="):
+                section = stripped
+                layout = path = None
+                prev = line
+                continue
+            prev = line
+
+            if (m := re.match(rf"Inference Time: {RE_UINT} us", stripped)):
+                add("single_inference_us", m.group(1))
+            elif section == "BENCHMARK RESULTS":
+                if (m := re.match(rf"Avg/inference: {RE_UINT} us", stripped)):
+                    add("avg_inference_us", m.group(1))
+                elif (m := re.match(rf"Throughput: {RE_UINT} FPS", stripped)):
+                    add("throughput_fps", m.group(1))
+                elif (m := re.match(rf"NPU cycles/inference: {RE_UINT}", stripped)):
+                    add("npu_cycles", m.group(1))
+                elif (m := re.match(rf"AXI (read|write)/inference: \d+ beats "
+                                    rf"\({RE_UINT} bytes\)", stripped)):
+                    add(f"npu_axi_{m.group(1)}_bytes", m.group(2))
+            elif section == "INPUT PACKING COMPARISON":
+                if (m := re.match(r"(\w+) slot <- (\w+) input", stripped)):
+                    layout = f"packing_{m.group(1).lower()}_{m.group(2).lower()}"
+                elif layout and (m := re.match(rf"Cycles/fill:\s+{RE_UINT}", stripped)):
+                    add(f"{layout}_cycles", m.group(1))
+                elif layout and (m := re.match(rf"Slot bytes:\s+{RE_UINT}", stripped)):
+                    add(f"{layout}_slot_bytes", m.group(1))
+            elif section == "CPU KERNEL COMPARISON":
+                m = re.match(rf"(Generic|Specialized):\s+{RE_UINT} cycles \(\d+ us\), "
+                             rf"{RE_UINT} bytes code", stripped)
+                if m:
+                    kind = "generic" if m.group(1) == "Generic" else "spec"
+                    add(f"cpu_{kind}_cycles", m.group(2))
+                    add(f"cpu_{kind}_code_bytes", m.group(3))
+            elif section == "MODEL INFORMATION":
+                if (m := re.match(rf"Model size: {RE_UINT} bytes", stripped)):
+                    add("model_bytes", m.group(1))
+            elif section == "MEMORY USAGE (high-water)":
+                if (m := re.match(rf"Stack: {RE_UINT} / \d+ bytes", stripped)):
+                    add("peak_stack_bytes", m.group(1))
+                elif re.match(r"(NPU|CPU) .*\(\d+ runs\)$", stripped):
+                    path = stripped
+                elif path and (m := re.match(rf"Arena:\s+{RE_UINT} bytes", stripped)):
+                    # One peak across all inference paths
+                    arena_peak = max(arena_peak or 0, int(m.group(1)))
+        if arena_peak is not None:
+            add("peak_arena_bytes", arena_peak)
+    return samples
+
+
+def parse_map_sizes(path):
+    """Output-section sizes from the linker map."""
+    _, outputs, _ = mem_report.parse_map(path)
+    names = {".text": "text_bytes", ".rodata": "rodata_bytes",
+             ".data": "data_bytes", ".bss": "bss_bytes",
+             ".tensor_arena": "tensor_arena_bytes"}
+    return {names[s['name']]: [float(s['size'])]
+            for s in outputs if s['name'] in names}
+
+
+def git_commit():
+    try:
+        sha = subprocess.run(["git", "rev-parse", "--short=12", "HEAD"], cwd=REPO_DIR,
+                             capture_output=True, text=True, check=True).stdout.strip()
+        dirty = subprocess.run(["git", "status", "--porcelain", "--untracked-files=no"],
+                               cwd=REPO_DIR, capture_output=True, text=True).stdout.strip()
+        return sha + ("-dirty" if dirty else "")
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def collect(args):
+    """Run/parse the benchmark and map into one history entry."""
+    if args.run:
+        print(f"Running: {args.run}")
+        result = subprocess.run(shlex.split(args.run), capture_output=True, text=True)
+        text = result.stdout
+        if result.returncode != 0:
+            raise SystemExit(f"ERROR: benchmark command failed ({result.returncode})")
+    elif args.log:
+        with open(args.log, "r", errors="replace") as f:
+            text = f.read()
+    else:
+        raise SystemExit("ERROR: pass --log FILE or --run CMD")
+
+    samples = parse_benchmark_log(text)
+    if not samples:
+        raise SystemExit("ERROR: no benchmark results found in output")
+    if not args.no_map:
+        if not os.path.exists(args.map):
+            raise SystemExit(f"ERROR: map file {args.map} not found "
+                             f"(--no-map for log-only runs)")
+        samples.update(parse_map_sizes(args.map))
+
+    return dict(commit=args.commit or git_commit(),
+                timestamp=time.strftime("%Y-%m-%dT%H:%M:%S"),
+                source=args.run or os.path.basename(args.log),
+                samples=samples)
+
+
+###############################################################################
+# History and baseline
+###############################################################################
+def load_history(path):
+    if not os.path.exists(path):
+        return []
+    with open(path) as f:
+        return [json.loads(line) for line in f if line.strip()]
+
+
+def append_history(path, entry):
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "a") as f:
+        f.write(json.dumps(entry, sort_keys=True) + "\n")
+
+
+def summarize(sample_lists):
+    values = [v for samples in sample_lists for v in samples]
+    return dict(median=statistics.median(values),
+                stdev=statistics.stdev(values) if len(values) > 1 else 0.0,
+                samples=len(values))
+
+
+def build_baseline(history, commit):
+    """Pool every run of commit into median/stdev per metric."""
+    runs = [e for e in history if e['commit'] == commit]
+    if not runs:
+        raise SystemExit(f"ERROR: no history entries for commit {commit}")
+    metrics = {}
+    for name in sorted({k for e in runs for k in e['samples']}):
+        metrics[name] = summarize([e['samples'][name] for e in runs
+                                   if name in e['samples']])
+    return dict(commit=commit, runs=len(runs), metrics=metrics)
+
+
+def compare(baseline, entry):
+    """Return (rows, failures) comparing entry against the baseline.
+
+    Baseline metrics absent from the entry fail as MISSING: a section that
+    stops printing (e.g. CPU kernels falling back to stubs) must not pass.
+    """
+    rows = []
+    regressions = []
+    for name in sorted(set(baseline['metrics']) - set(entry['samples'])):
+        rows.append((name, baseline['metrics'][name]['median'], None, None, None,
+                     "MISSING"))
+        regressions.append(name)
+    for name, samples in sorted(entry['samples'].items()):
+        spec = metric_spec(name)
+        base = baseline['metrics'].get(name)
+        value = statistics.median(samples)
+        if spec is None or base is None:
+            rows.append((name, None, value, None, None, "new"))
+            continue
+        ref = base['median']
+        threshold = max(spec['rel'] * abs(ref), spec['sigma'] * base['stdev'],
+                        spec['abs'])
+        delta = value - ref
+        worse = delta if spec['better'] == "lower" else -delta
+        if worse > threshold:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif worse < -threshold:
+            status = "improved"
+        else:
+            status = "ok"
+        pct = 100.0 * delta / ref if ref else 0.0
+        rows.append((name, ref, value, pct, threshold, status))
+    rows.sort(key=lambda r: r[0])
+    return rows, regressions
+
+
+def print_comparison(baseline, entry, rows):
+    print("=" * 78)
+    print(f"PERF GATE: {entry['commit']} vs baseline {baseline['commit']} "
+          f"({baseline['runs']} runs)")
+    print("=" * 78)
+    print(f"{'Metric':34s} {'Baseline':>11s} {'Current':>11s} {'Delta':>8s} "
+          f"{'Thresh':>8s}  Status")
+    for name, ref, value, pct, threshold, status in rows:
+        ref_s = "-" if ref is None else f"{ref:,.0f}"
+        value_s = "-" if value is None else f"{value:,.0f}"
+        pct_s = "-" if pct is None else f"{pct:+.1f}%"
+        thr_s = "-" if threshold is None else f"{threshold:,.0f}"
+        print(f"{name[:34]:34s} {ref_s:>11s} {value_s:>11s} {pct_s:>8s} "
+              f"{thr_s:>8s}  {status}")
+    print("=" * 78)
+
+
+###############################################################################
+# Commands
+###############################################################################
+def cmd_record(args):
+    entry = collect(args)
+    append_history(args.history, entry)
+    print(f"Recorded {len(entry['samples'])} metrics for {entry['commit']} "
+          f"in {args.history}")
+    return 0
+
+
+def cmd_baseline(args):
+    history = load_history(args.history)
+    if not history:
+        raise SystemExit(f"ERROR: history {args.history} is empty")
+    commit = args.commit or history[-1]['commit']
+    baseline = build_baseline(history, commit)
+    os.makedirs(os.path.dirname(os.path.abspath(args.baseline)), exist_ok=True)
+    with open(args.baseline, "w") as f:
+        json.dump(baseline, f, indent=2, sort_keys=True)
+    print(f"Baseline set to {commit} ({baseline['runs']} runs, "
+          f"{len(baseline['metrics'])} metrics) in {args.baseline}")
+    return 0
+
+
+def cmd_check(args):
+    if not os.path.exists(args.baseline):
+        raise SystemExit(f"ERROR: no baseline at {args.baseline}; "
+                         f"run 'record' then 'baseline' first")
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    entry = collect(args)
+    if not args.no_record:
+        append_history(args.history, entry)
+    rows, regressions = compare(baseline, entry)
+    print_comparison(baseline, entry, rows)
+    if regressions:
+        print(f"FAILED: {len(regressions)} regressed or missing metric(s): "
+              f"{', '.join(regressions)}")
+        return 1
+    print("PASSED: no regressions")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    def add_common(p, inputs):
+        p.add_argument("--history", default=DEFAULT_HISTORY)
+        p.add_argument("--baseline", default=DEFAULT_BASELINE)
+        p.add_argument("--commit", help="commit key (default: git HEAD)")
+        if inputs:
+            p.add_argument("--log", help="captured RTT log with benchmark output")
+            p.add_argument("--run", help="command that prints benchmark output")
+            p.add_argument("--map", default=DEFAULT_MAP, help="linker map file")
+            p.add_argument("--no-map", action="store_true",
+                           help="skip section sizes (log-only run)")
+
+    add_common(sub.add_parser("record", help="parse a run into the history"), True)
+    add_common(sub.add_parser("baseline", help="set baseline from history"), False)
+    check = sub.add_parser("check", help="compare a run against the baseline")
+    add_common(check, True)
+    check.add_argument("--no-record", action="store_true",
+                       help="don't append this run to the history")
+
+    args = parser.parse_args()
+    return {"record": cmd_record, "baseline": cmd_baseline,
+            "check": cmd_check}[args.command](args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,41 +11,53 @@ echo "========================================"
 
 cd "$(dirname "$0")/.."
 
+# Model and output directory (overridable for compression/architecture sweeps)
+MODEL="${MODEL:-model/mnist_model.tflite}"
+VELA_OUTPUT_DIR="${VELA_OUTPUT_DIR:-model/vela_output}"
+VELA_MODEL="$VELA_OUTPUT_DIR/$(basename "$MODEL" .tflite)_vela.tflite"
+
+# VELA_PER_LAYER=1 also writes <model>_per-layer.csv performance estimates
+VELA_EXTRA_ARGS=""
+if [ "${VELA_PER_LAYER:-0}" = "1" ]; then
+    VELA_EXTRA_ARGS="--verbose-performance"
+fi
+
 # Check if model exists
-if [ ! -f "model/mnist_model.tflite" ]; then
-    echo "ERROR: model/mnist_model.tflite not found!"
+if [ ! -f "$MODEL" ]; then
+    echo "ERROR: $MODEL not found!"
     echo "Run 'python scripts/train_mnist.py' first."
     exit 1
 fi
 
 # Create output directory
-mkdir -p model/vela_output
+mkdir -p "$VELA_OUTPUT_DIR"
 
 # Run Vela compiler
 echo ""
 echo "Running Vela compiler..."
 echo ""
 
-vela model/mnist_model.tflite \
+vela "$MODEL" \
     --accelerator-config ethos-u55-128 \
     --config vela_config.ini \
     --system-config Ethos_U55_High_End_Embedded \
     --memory-mode Shared_Sram \
-    --output-dir model/vela_output
+    --output-dir "$VELA_OUTPUT_DIR" \
+    $VELA_EXTRA_ARGS
 
 echo ""
 echo "========================================"
 echo " Vela Optimization Complete"
 echo "========================================"
 echo ""
-echo "Original model:  model/mnist_model.tflite"
-echo "Optimized model: model/vela_output/mnist_model_vela.tflite"
+echo "Original model:  $MODEL"
+echo "Optimized model: $VELA_MODEL"
 echo ""
 
 # Show file sizes
 echo "File sizes:"
-ls -lh model/mnist_model.tflite
-ls -lh model/vela_output/mnist_model_vela.tflite
+ls -lh "$MODEL"
+ls -lh "$VELA_MODEL"
 
 echo ""
 echo "Next: Run 'python scripts/generate_headers.py'"
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+Full-INT8 TFLite Conversion and Evaluation
+==========================================
+Converts a Keras model to a full-INT8 TFLite flatbuffer (Keras 3 compatible,
+via SavedModel export) and measures its accuracy with the TFLite interpreter.
+
+Inputs are quantized the way the TFLite reference kernels do it: round to
+nearest, then clip to the int8 range.
+
+Shared by train_mnist.py (deployed model and compression variants) and
+arch_sweep.py, so their INT8 accuracies are measured the same way.
+"""
+
+import tempfile
+
+import numpy as np
+import tensorflow as tf
+
+CALIBRATION_SAMPLES = 200
+
+
+def convert_to_int8_tflite(keras_model, x_calib, samples=CALIBRATION_SAMPLES):
+    """Convert a Keras model to a full-INT8 TFLite flatbuffer."""
+    def representative_dataset_generator():
+        indices = np.random.choice(len(x_calib), samples, replace=False)
+        for idx in indices:
+            yield [x_calib[idx:idx+1].astype(np.float32)]
+
+    # Keras 3: export to SavedModel first
+    with tempfile.TemporaryDirectory() as saved_model_dir:
+        keras_model.export(saved_model_dir)
+        converter = tf.lite.TFLiteConverter.from_saved_model(saved_model_dir)
+        converter.optimizations = [tf.lite.Optimize.DEFAULT]
+        converter.representative_dataset = representative_dataset_generator
+        converter.target_spec.supported_ops = [tf.lite.OpsSet.TFLITE_BUILTINS_INT8]
+        converter.inference_input_type = tf.int8
+        converter.inference_output_type = tf.int8
+        return converter.convert()
+
+
+def quantize_input(images, scale, zero_point):
+    """Quantize float images in [0, 1] to int8 (round, then clip)."""
+    if scale == 0:
+        scale, zero_point = 1.0 / 255.0, -128
+    q = np.round(np.asarray(images, dtype=np.float32) / scale + zero_point)
+    return np.clip(q, -128, 127).astype(np.int8)
+
+
+def evaluate_int8(tflite_bytes, images, labels):
+    """Return (accuracy, input_details, output_details) of an INT8 model."""
+    interpreter = tf.lite.Interpreter(model_content=tflite_bytes)
+    interpreter.allocate_tensors()
+    inp = interpreter.get_input_details()[0]
+    out = interpreter.get_output_details()[0]
+    scale, zero_point = inp['quantization']
+
+    correct = 0
+    for image, label in zip(images, labels):
+        interpreter.set_tensor(inp['index'],
+                               quantize_input(image, scale, zero_point)[np.newaxis])
+        interpreter.invoke()
+        if np.argmax(interpreter.get_tensor(out['index'])[0]) == label:
+            correct += 1
+    return correct / len(labels), inp, out
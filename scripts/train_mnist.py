@@ -8,14 +8,38 @@ This script:
 1. Trains a CNN on MNIST dataset
 2. Quantizes to INT8 for embedded deployment
 3. Exports TFLite model ready for Vela optimization
+4. Optionally (--compress) fine-tunes pruned / clustered / quantization-aware
+   variants, compiles each with run_vela.sh and tabulates size, cycles,
+   off-chip traffic and INT8 accuracy
 """
 
+import argparse
+import csv
 import tensorflow as tf
 import numpy as np
 import os
-import tempfile
 import json
 
+import tflite_int8
+import vela_stats
+
+parser = argparse.ArgumentParser(description="Train MNIST CNN for Ethos-U55")
+parser.add_argument("--compress", action="store_true",
+                    help="also build and compare compression variants")
+parser.add_argument("--variants", default="prune,cluster,qat,prune+cluster,"
+                    "prune+cluster+qat",
+                    help="comma-separated variants; stages joined by '+' "
+                         "(prune, cluster, qat)")
+parser.add_argument("--sparsity", type=float, default=0.5,
+                    help="fraction of conv filters / dense inputs to prune")
+parser.add_argument("--clusters", type=int, default=16,
+                    help="number of weight clusters per layer")
+parser.add_argument("--finetune-epochs", type=int, default=2,
+                    help="fine-tuning epochs per compression stage")
+parser.add_argument("--min-accuracy", type=float, default=0.98,
+                    help="INT8 accuracy bar for picking a variant")
+args = parser.parse_args()
+
 print("=" * 70)
 print("MNIST Training for Alif E8 Ethos-U55 NPU")
 print("=" * 70)
@@ -117,11 +141,7 @@ print("\n" + "=" * 70)
 print("STEP 5: Preparing Quantization")
 print("=" * 70)
 
-def representative_dataset_generator():
-    """Generate samples for INT8 quantization calibration."""
-    indices = np.random.choice(len(x_train), 200, replace=False)
-    for idx in indices:
-        yield [x_train[idx:idx+1].astype(np.float32)]
+print(f"Calibration: {tflite_int8.CALIBRATION_SAMPLES} random training images")
 
 ###############################################################################
 # STEP 6: Convert to TFLite INT8 (Keras 3 Compatible)
@@ -132,21 +152,8 @@ print("=" * 70)
 
 os.makedirs("../model", exist_ok=True)
 
-# FIX FOR KERAS 3: Export to SavedModel first
-print("Exporting to SavedModel format...")
-with tempfile.TemporaryDirectory() as saved_model_dir:
-    model.export(saved_model_dir)
-    
-    print("Converting to TFLite INT8...")
-    converter = tf.lite.TFLiteConverter.from_saved_model(saved_model_dir)
-    
-    converter.optimizations = [tf.lite.Optimize.DEFAULT]
-    converter.representative_dataset = representative_dataset_generator
-    converter.target_spec.supported_ops = [tf.lite.OpsSet.TFLITE_BUILTINS_INT8]
-    converter.inference_input_type = tf.int8
-    converter.inference_output_type = tf.int8
-    
-    tflite_model = converter.convert()
+print("Exporting to SavedModel and converting to TFLite INT8...")
+tflite_model = tflite_int8.convert_to_int8_tflite(model, x_train)
 
 # Save model
 tflite_path = "../model/mnist_model.tflite"
@@ -163,11 +170,9 @@ print("\n" + "=" * 70)
 print("STEP 7: Verifying Quantized Model")
 print("=" * 70)
 
-interpreter = tf.lite.Interpreter(model_content=tflite_model)
-interpreter.allocate_tensors()
-
-input_details = interpreter.get_input_details()[0]
-output_details = interpreter.get_output_details()[0]
+EVAL_SAMPLES = 1000
+quantized_accuracy, input_details, output_details = tflite_int8.evaluate_int8(
+    tflite_model, x_test[:EVAL_SAMPLES], y_test[:EVAL_SAMPLES])
 
 print(f"Input: {input_details['dtype']}, shape {input_details['shape']}")
 print(f"Output: {output_details['dtype']}, shape {output_details['shape']}")
@@ -175,23 +180,6 @@ print(f"Output: {output_details['dtype']}, shape {output_details['shape']}")
 input_scale = input_details['quantization'][0]
 input_zero_point = input_details['quantization'][1]
 
-# Test accuracy
-correct = 0
-for i in range(1000):
-    test_image = x_test[i:i+1]
-    if input_scale != 0:
-        test_image_int8 = (test_image / input_scale + input_zero_point).astype(np.int8)
-    else:
-        test_image_int8 = ((test_image * 255) - 128).astype(np.int8)
-    
-    interpreter.set_tensor(input_details['index'], test_image_int8)
-    interpreter.invoke()
-    output = interpreter.get_tensor(output_details['index'])[0]
-    
-    if np.argmax(output) == y_test[i]:
-        correct += 1
-
-quantized_accuracy = correct / 1000
 print(f"Quantized Accuracy: {quantized_accuracy:.4f}")
 
 ###############################################################################
@@ -205,10 +193,7 @@ test_idx = 0
 test_image = x_test[test_idx]
 test_label = int(y_test[test_idx])
 
-if input_scale != 0:
-    test_image_int8 = (test_image / input_scale + input_zero_point).astype(np.int8)
-else:
-    test_image_int8 = ((test_image * 255) - 128).astype(np.int8)
+test_image_int8 = tflite_int8.quantize_input(test_image, input_scale, input_zero_point)
 
 np.save("../model/test_image_int8.npy", test_image_int8)
 np.save("../model/test_label.npy", test_label)
@@ -224,6 +209,237 @@ with open("../model/quantization_params.json", "w") as f:
 
 print(f"Test image saved (digit: {test_label})")
 
+###############################################################################
+# STEP 9: Compression Variants (optional, --compress)
+###############################################################################
+# Vela's weight encoder compresses runs of zeros and small sets of repeated
+# values far better than dense, unique weights. Each variant starts from the
+# trained model, applies its stages in order and is fine-tuned after each:
+#   prune   - zero the lowest-L1 conv filters / dense inputs (structured)
+#   cluster - share K centroid values per layer (k-means)
+#   qat     - fine-tune against per-channel INT8 fake-quantized weights
+#             (straight-through estimator; BN is folded later by the
+#             converter, so this approximates the deployed weights)
+
+COMPRESSIBLE = (tf.keras.layers.Conv2D, tf.keras.layers.Dense)
+
+
+class WeightConstraints(tf.keras.callbacks.Callback):
+    """Re-applies pruning masks and cluster sharing after every batch."""
+
+    def __init__(self):
+        super().__init__()
+        self.masks = {}      # layer name -> 0/1 mask
+        self.clusters = {}   # layer name -> cluster index per weight
+
+    def apply(self, keras_model):
+        for layer in keras_model.layers:
+            if layer.name not in self.masks and layer.name not in self.clusters:
+                continue
+            kernel = layer.kernel.numpy()
+            if layer.name in self.clusters:
+                assign = self.clusters[layer.name]
+                mask = self.masks.get(layer.name, np.ones_like(kernel))
+                flat = kernel.flatten()
+                keep = mask.flatten() != 0
+                for c in np.unique(assign[keep]):
+                    members = keep & (assign == c)
+                    flat[members] = flat[members].mean()
+                kernel = flat.reshape(kernel.shape)
+            if layer.name in self.masks:
+                kernel = kernel * self.masks[layer.name]
+            layer.kernel.assign(kernel)
+
+    def on_train_batch_end(self, batch, logs=None):
+        self.apply(self.model)
+
+
+def prune_structured(keras_model, constraints, sparsity):
+    """Mask the lowest-L1 output filters (conv) or input rows (dense)."""
+    for layer in keras_model.layers:
+        if not isinstance(layer, COMPRESSIBLE):
+            continue
+        kernel = layer.kernel.numpy()
+        if isinstance(layer, tf.keras.layers.Conv2D):
+            axis = kernel.ndim - 1                   # output filters
+        else:
+            axis = 0                                 # input features
+        other = tuple(a for a in range(kernel.ndim) if a != axis)
+        norms = np.abs(kernel).sum(axis=other)
+        n_prune = int(round(sparsity * norms.size))
+        if n_prune == 0 or n_prune >= norms.size:
+            continue
+        mask = np.ones_like(kernel)
+        index = [slice(None)] * kernel.ndim
+        index[axis] = np.argsort(norms)[:n_prune]
+        mask[tuple(index)] = 0
+        constraints.masks[layer.name] = mask
+        print(f"  {layer.name}: pruned {n_prune}/{norms.size}")
+
+
+def cluster_weights(keras_model, constraints, num_clusters, iterations=20):
+    """Assign each (unpruned) weight to one of K k-means centroids."""
+    for layer in keras_model.layers:
+        if not isinstance(layer, COMPRESSIBLE):
+            continue
+        flat = layer.kernel.numpy().flatten()
+        keep = constraints.masks.get(layer.name, np.ones_like(layer.kernel.numpy()))
+        keep = keep.flatten() != 0
+        values = flat[keep]
+        centroids = np.linspace(values.min(), values.max(), num_clusters)
+        for _ in range(iterations):
+            assign = np.argmin(np.abs(values[:, None] - centroids[None, :]), axis=1)
+            for c in range(num_clusters):
+                if np.any(assign == c):
+                    centroids[c] = values[assign == c].mean()
+        full = np.zeros(flat.shape, dtype=np.int32)
+        full[keep] = assign
+        constraints.clusters[layer.name] = full
+        print(f"  {layer.name}: {len(np.unique(assign))} clusters")
+    constraints.apply(keras_model)
+
+
+def fake_quant_per_channel(kernel):
+    """Symmetric per-output-channel INT8 round trip (output axis is last)."""
+    axes = tuple(range(kernel.ndim - 1))
+    scale = np.maximum(np.abs(kernel).max(axis=axes, keepdims=True), 1e-8) / 127.0
+    return np.clip(np.round(kernel / scale), -127, 127) * scale
+
+
+def finetune(keras_model, constraints, epochs, qat=False):
+    """Fine-tune with constraints applied; optionally quantization-aware."""
+    keras_model.compile(
+        optimizer=tf.keras.optimizers.Adam(learning_rate=1e-4),
+        loss=tf.keras.losses.SparseCategoricalCrossentropy(from_logits=True),
+        metrics=['accuracy']
+    )
+    if not qat:
+        keras_model.fit(x_train, y_train, batch_size=128, epochs=epochs,
+                        validation_split=0.1, callbacks=[constraints], verbose=2)
+        return
+
+    loss_fn = tf.keras.losses.SparseCategoricalCrossentropy(from_logits=True)
+    optimizer = tf.keras.optimizers.Adam(learning_rate=1e-4)
+    layers = [l for l in keras_model.layers if isinstance(l, COMPRESSIBLE)]
+    dataset = tf.data.Dataset.from_tensor_slices((x_train, y_train)) \
+                             .shuffle(10000, seed=42).batch(128)
+    for epoch in range(epochs):
+        losses = []
+        for xb, yb in dataset:
+            shadow = [l.kernel.numpy() for l in layers]
+            for l, w in zip(layers, shadow):
+                l.kernel.assign(fake_quant_per_channel(w))
+            with tf.GradientTape() as tape:
+                loss = loss_fn(yb, keras_model(xb, training=True))
+            grads = tape.gradient(loss, keras_model.trainable_variables)
+            # Straight-through: apply the quantized-weight gradients to the
+            # float shadow weights
+            for l, w in zip(layers, shadow):
+                l.kernel.assign(w)
+            optimizer.apply_gradients(zip(grads, keras_model.trainable_variables))
+            constraints.apply(keras_model)
+            losses.append(float(loss))
+        print(f"  QAT epoch {epoch + 1}/{epochs}: loss {np.mean(losses):.4f}")
+
+
+def vela_report(name, tflite_path, accuracy):
+    """Compile with Vela and collect the size/cycles/traffic row."""
+    row = dict(variant=name, tflite_bytes=os.path.getsize(tflite_path),
+               vela_bytes=None, npu_cycles=None, offchip_bytes=None,
+               offchip_weight_read_bytes=None, int8_accuracy=accuracy)
+    out_dir = os.path.join(os.path.dirname(tflite_path), "vela")
+    try:
+        vela_stats.run_vela(tflite_path, out_dir)
+        summary = vela_stats.read_summary(out_dir)
+        row.update(vela_bytes=os.path.getsize(vela_stats.vela_model_path(out_dir)),
+                   npu_cycles=summary['npu_cycles'],
+                   offchip_bytes=summary['offchip_bytes'],
+                   offchip_weight_read_bytes=summary['offchip_weight_read_bytes'])
+    except vela_stats.VelaError as e:
+        print(f"  Vela unavailable for {name}: {e}")
+    return row
+
+
+compression_rows = []
+if args.compress:
+    print("\n" + "=" * 70)
+    print("STEP 9: Compression Variants")
+    print("=" * 70)
+
+    variants_dir = "../model/variants"
+    base_dir = os.path.join(variants_dir, "baseline")
+    os.makedirs(base_dir, exist_ok=True)
+    base_path = os.path.join(base_dir, "mnist_model.tflite")
+    with open(base_path, "wb") as f:
+        f.write(tflite_model)
+    compression_rows.append(vela_report("baseline", base_path, quantized_accuracy))
+
+    for variant in [v.strip() for v in args.variants.split(",") if v.strip()]:
+        stages = variant.split("+")
+        unknown = [s for s in stages if s not in ("prune", "cluster", "qat")]
+        if unknown:
+            raise SystemExit(f"ERROR: unknown stage(s) {unknown} in '{variant}'")
+
+        print(f"\n--- Variant: {variant} ---")
+        variant_model = tf.keras.models.clone_model(model)
+        variant_model.set_weights(model.get_weights())
+        constraints = WeightConstraints()
+        for stage in stages:
+            if stage == "prune":
+                prune_structured(variant_model, constraints, args.sparsity)
+                constraints.apply(variant_model)
+                finetune(variant_model, constraints, args.finetune_epochs)
+            elif stage == "cluster":
+                cluster_weights(variant_model, constraints, args.clusters)
+                finetune(variant_model, constraints, args.finetune_epochs)
+            elif stage == "qat":
+                finetune(variant_model, constraints, args.finetune_epochs, qat=True)
+
+        variant_tflite = tflite_int8.convert_to_int8_tflite(variant_model, x_train)
+        accuracy, _, _ = tflite_int8.evaluate_int8(
+            variant_tflite, x_test[:EVAL_SAMPLES], y_test[:EVAL_SAMPLES])
+        out_dir = os.path.join(variants_dir, variant.replace("+", "_"))
+        os.makedirs(out_dir, exist_ok=True)
+        tflite_path = os.path.join(out_dir, "mnist_model.tflite")
+        with open(tflite_path, "wb") as f:
+            f.write(variant_tflite)
+        compression_rows.append(vela_report(variant, tflite_path, accuracy))
+
+    def fmt(v, spec="{:,.0f}"):
+        return "n/a" if v is None else spec.format(v)
+
+    print("\n" + "=" * 70)
+    print("COMPRESSION RESULTS")
+    print("=" * 70)
+    print(f"{'Variant':20s} {'TFLite B':>9s} {'Vela B':>9s} {'NPU cyc':>9s} "
+          f"{'Offchip B':>10s} {'Offchip wt B':>12s} {'INT8 acc':>8s}")
+    for r in compression_rows:
+        print(f"{r['variant']:20s} {fmt(r['tflite_bytes']):>9s} "
+              f"{fmt(r['vela_bytes']):>9s} {fmt(r['npu_cycles']):>9s} "
+              f"{fmt(r['offchip_bytes']):>10s} {fmt(r['offchip_weight_read_bytes']):>12s} "
+              f"{r['int8_accuracy']:8.4f}")
+
+    report_path = os.path.join(variants_dir, "compression_report.csv")
+    with open(report_path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(compression_rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(compression_rows)
+    print(f"\nReport saved: {report_path}")
+
+    # Smallest, then fastest, variant that meets the accuracy bar
+    eligible = [r for r in compression_rows
+                if r['int8_accuracy'] >= args.min_accuracy]
+    if eligible:
+        best = min(eligible, key=lambda r: (
+            r['vela_bytes'] if r['vela_bytes'] is not None else r['tflite_bytes'],
+            r['npu_cycles'] if r['npu_cycles'] is not None else 0))
+        best_path = os.path.join(variants_dir, best['variant'].replace("+", "_"),
+                                 "mnist_model.tflite")
+        print(f"Best variant (INT8 acc >= {args.min_accuracy}): {best['variant']}")
+        print(f"  Deploy with: MODEL={os.path.relpath(best_path, '..')} ./run_vela.sh")
+    else:
+        print(f"No variant meets INT8 accuracy >= {args.min_accuracy}")
+
 ###############################################################################
 # SUMMARY
 ###############################################################################
@@ -234,6 +450,8 @@ print(f"  Float32 Accuracy:    {test_accuracy:.4f}")
 print(f"  INT8 Accuracy:       {quantized_accuracy:.4f}")
 print(f"  Model Size:          {len(tflite_model)/1024:.1f} KB")
 print(f"  Test Digit:          {test_label}")
+if compression_rows:
+    print("  Compression report:  ../model/variants/compression_report.csv")
 print("=" * 70)
 print("\nNext: Run ./run_vela.sh to optimize for NPU")
 print("=" * 70)
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+Vela Runner and Performance Report Parser
+=========================================
+Runs run_vela.sh on a model and reads back the estimates Vela writes to its
+output directory:
+  - <model>_summary_<system_config>.csv  (one row per network)
+  - <model>_per-layer.csv               (one row per operator, written when
+                                         Vela runs with --verbose-performance)
+
+Shared by train_mnist.py (compression variants) and arch_sweep.py.
+"""
+
+import csv
+import glob
+import os
+import subprocess
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(SCRIPT_DIR)
+RUN_VELA = os.path.join(SCRIPT_DIR, "run_vela.sh")
+
+# Memory areas Vela reports; everything except SRAM is off-chip traffic
+OFFCHIP_AREAS = ("dram", "on_chip_flash", "off_chip_flash")
+
+
+class VelaError(Exception):
+    pass
+
+
+def run_vela(model_path, output_dir, verbose=False, per_layer=False):
+    """Compile model_path with run_vela.sh into output_dir; return output_dir."""
+    env = dict(os.environ,
+               MODEL=os.path.relpath(os.path.abspath(model_path), REPO_DIR),
+               VELA_OUTPUT_DIR=os.path.relpath(os.path.abspath(output_dir), REPO_DIR),
+               VELA_PER_LAYER="1" if per_layer else "0")
+    try:
+        result = subprocess.run([RUN_VELA], env=env, capture_output=not verbose,
+                                text=True)
+    except OSError as e:
+        raise VelaError(f"cannot run {RUN_VELA}: {e}")
+    if result.returncode != 0:
+        tail = (result.stdout or "")[-400:] + (result.stderr or "")[-400:]
+        raise VelaError(f"run_vela.sh failed for {model_path}\n{tail}")
+    return output_dir
+
+
+def _number(value):
+    try:
+        return float(value)
+    except (TypeError, ValueError):
+        return None
+
+
+def _read_rows(path):
+    with open(path, newline="") as f:
+        return [{k.strip(): v for k, v in row.items() if k}
+                for row in csv.DictReader(f)]
+
+
+def _find(output_dir, pattern):
+    matches = sorted(glob.glob(os.path.join(output_dir, pattern)))
+    return matches[0] if matches else None
+
+
+def read_summary(output_dir):
+    """Return normalized network-level estimates from the summary CSV."""
+    path = _find(output_dir, "*_summary_*.csv")
+    if path is None:
+        raise VelaError(f"no Vela summary CSV in {output_dir}")
+    row = _read_rows(path)[0]
+
+    def col(*names):
+        for name in names:
+            if _number(row.get(name)) is not None:
+                return _number(row[name])
+        return None
+
+    offchip = 0.0
+    weight_reads = 0.0
+    for key, value in row.items():
+        v = _number(value)
+        if v is None:
+            continue
+        if not key.startswith(OFFCHIP_AREAS):
+            continue
+        # SRAM weight reads repeat the buffered off-chip weights; skip them
+        if key.endswith("_total_bytes"):
+            offchip += v
+        elif key.endswith("_weight_read_bytes"):
+            weight_reads += v
+
+    return dict(
+        npu_cycles=col("cycles_npu", "npu_cycles"),
+        total_cycles=col("cycles_total", "total_cycles"),
+        inference_time_s=col("inference_time"),
+        sram_used_kib=col("sram_memory_used"),
+        offchip_bytes=offchip,
+        offchip_weight_read_bytes=weight_reads,
+        weights_original=col("total_original_weights"),
+        weights_encoded=col("total_npu_encoded_weights"),
+        csv=path,
+    )
+
+
+def read_per_layer(output_dir):
+    """Return per-operator rows from the per-layer CSV (may be empty)."""
+    path = _find(output_dir, "*_per-layer.csv")
+    if path is None:
+        return []
+    return _read_rows(path)
+
+
+def _column(rows, *keywords):
+    """First column whose name contains all keywords (case-insensitive)."""
+    for key in rows[0].keys():
+        name = key.lower()
+        if all(k in name for k in keywords):
+            return key
+    return None
+
+
+def summarize_per_layer(rows):
+    """Total cycles, peak SRAM and the most expensive operator."""
+    if not rows:
+        return None
+    cycles_key = _column(rows, "cycles")
+    sram_key = _column(rows, "sram", "usage")
+    name_key = _column(rows, "name") or _column(rows, "operator")
+    cycles = [_number(r.get(cycles_key)) or 0.0 for r in rows] if cycles_key else []
+    sram = [_number(r.get(sram_key)) or 0.0 for r in rows] if sram_key else []
+    top = None
+    if cycles:
+        i = max(range(len(rows)), key=lambda j: cycles[j])
+        top = rows[i].get(name_key, "?") if name_key else "?"
+    return dict(layers=len(rows),
+                cycles=sum(cycles) if cycles else None,
+                peak_sram_bytes=max(sram) if sram else None,
+                top_layer=top)
+
+
+def vela_model_path(output_dir):
+    """Path of the Vela-optimized .tflite in output_dir."""
+    path = _find(output_dir, "*_vela.tflite")
+    if path is None:
+        raise VelaError(f"no *_vela.tflite in {output_dir}")
+    return path